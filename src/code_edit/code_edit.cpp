@@ -20,8 +20,13 @@
  */
 
 #include "tkc/fs.h"
+#include "tkc/path.h"
 #include "tkc/mem.h"
 #include "tkc/utils.h"
+#include "tkc/mutex.h"
+#include "tkc/thread.h"
+#include "tkc/time_now.h"
+#include "base/idle.h"
 #include "base/widget_vtable.h"
 #include "base/window_manager.h"
 #include "code_edit.h"
@@ -33,6 +38,10 @@
 #include <cstdio>
 #include <ctime>
 #include <cmath>
+#include <sys/stat.h>
+#ifndef WIN32
+#include <unistd.h>
+#endif /*WIN32*/
 
 #include <stdexcept>
 #include <new>
@@ -85,14 +94,59 @@
 #include "sci_lang_names.h"
 #include "base/input_method.h"
 #include "code_edit/code_theme.h"
+#include "scintilla/awtk/PlatAWTK.h"
 #include "scintilla/awtk/ScintillaAWTK.h"
 
+using Scintilla::FontCacheStats;
 using Scintilla::ScintillaAWTK;
 using Scintilla::Surface;
 
 #define SSM(m, w, l) impl->DefWndProc(m, w, l)
 static ret_t code_edit_get_text(widget_t* widget, value_t* v);
 static ret_t code_edit_set_text(widget_t* widget, const value_t* v);
+static ret_t code_edit_attach_document(widget_t* widget, void* doc, bool_t mapped);
+static ret_t code_edit_unmap_document(widget_t* widget);
+
+/*把ScintillaAWTK的通知转换为code_edit的事件。*/
+class CodeEditListener : public Scintilla::ScintillaAWTKListener {
+ public:
+  explicit CodeEditListener(widget_t* widget) : widget(widget) {
+  }
+
+  virtual void OnTextChanged(Sci::Position position, Sci::Position deleted, const char* inserted,
+                             Sci::Position insertedLength) override {
+    code_edit_text_changed_event_t evt;
+
+    memset(&evt, 0x00, sizeof(evt));
+    evt.e = event_init(EVT_CODE_EDIT_TEXT_CHANGED, this->widget);
+    evt.e.size = sizeof(evt);
+    evt.offset = position;
+    evt.deleted_length = deleted;
+    evt.inserted_length = insertedLength;
+    evt.inserted = inserted;
+
+    widget_dispatch(this->widget, &(evt.e));
+  }
+
+  virtual void OnStyling(double duration, Sci::Line lines, Sci::Position endStyled,
+                         Sci::Position length, bool idle) override {
+    code_edit_styling_event_t evt;
+
+    memset(&evt, 0x00, sizeof(evt));
+    evt.e = event_init(EVT_CODE_EDIT_STYLING, this->widget);
+    evt.e.size = sizeof(evt);
+    evt.duration_us = (uint32_t)(duration * 1000000);
+    evt.lines = (uint32_t)lines;
+    evt.end_styled = endStyled;
+    evt.length = length;
+    evt.idle = idle;
+
+    widget_dispatch(this->widget, &(evt.e));
+  }
+
+ private:
+  widget_t* widget;
+};
 
 static ret_t code_edit_on_word_style(void* ctx, code_style_t* style) {
   ScintillaAWTK* impl = NULL;
@@ -172,6 +226,7 @@ static ret_t code_edit_apply_lang_theme(widget_t* widget) {
 
     return_value_if_fail(lexer >= 0, RET_BAD_PARAMS);
     SSM(SCI_SETLEXER, lexer, 0);
+    impl->RequestBackgroundLexing();
   }
 
   return RET_OK;
@@ -227,6 +282,11 @@ ret_t code_edit_set_show_line_number(widget_t* widget, bool_t show_line_number)
   return RET_OK;
 }
 
+/*映射的文档始终只读，readonly只记录用户的设置，解除映射后恢复。*/
+static bool_t code_edit_is_readonly(code_edit_t* code_edit) {
+  return code_edit->readonly || code_edit->mapped;
+}
+
 ret_t code_edit_set_readonly(widget_t* widget, bool_t readonly) {
   ScintillaAWTK* impl = NULL;
   code_edit_t* code_edit = CODE_EDIT(widget);
@@ -236,7 +296,7 @@ ret_t code_edit_set_readonly(widget_t* widget, bool_t readonly) {
 
   code_edit->readonly = readonly;
 
-  SSM(SCI_SETREADONLY, readonly, 0);
+  SSM(SCI_SETREADONLY, code_edit_is_readonly(code_edit), 0);
 
   return RET_OK;
 }
@@ -290,6 +350,73 @@ ret_t code_edit_set_scroll_line(widget_t* widget, int32_t scroll_line) {
   return RET_OK;
 }
 
+ret_t code_edit_set_atomic_save(widget_t* widget, bool_t atomic_save) {
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  code_edit->atomic_save = atomic_save;
+  return RET_OK;
+}
+
+ret_t code_edit_set_keep_backup(widget_t* widget, bool_t keep_backup) {
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  code_edit->keep_backup = keep_backup;
+  return RET_OK;
+}
+
+ret_t code_edit_set_background_lexing(widget_t* widget, bool_t background_lexing) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+
+  code_edit->background_lexing = background_lexing;
+  impl->SetBackgroundLexing(background_lexing);
+
+  return RET_OK;
+}
+
+ret_t code_edit_set_idle_styling(widget_t* widget, uint32_t idle_styling) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+  return_value_if_fail(idle_styling <= SC_IDLESTYLING_ALL, RET_BAD_PARAMS);
+
+  code_edit->idle_styling = idle_styling;
+  SSM(SCI_SETIDLESTYLING, idle_styling, 0);
+
+  return RET_OK;
+}
+
+ret_t code_edit_set_styling_budget_us(widget_t* widget, uint32_t styling_budget_us) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+
+  code_edit->styling_budget_us = styling_budget_us;
+  impl->SetStylingBudget(styling_budget_us);
+
+  return RET_OK;
+}
+
+ret_t code_edit_set_lex_threads(widget_t* widget, uint32_t lex_threads) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+
+  code_edit->lex_threads = lex_threads;
+  impl->SetLexThreads(lex_threads);
+
+  return RET_OK;
+}
+
 ret_t code_edit_insert_text(widget_t* widget, uint32_t offset, const char* text) {
   ScintillaAWTK* impl = NULL;
   code_edit_t* code_edit = CODE_EDIT(widget);
@@ -307,6 +434,140 @@ ret_t code_edit_insert_text(widget_t* widget, uint32_t offset, const char* text)
   return RET_OK;
 }
 
+ret_t code_edit_replace_text(widget_t* widget, uint32_t start, uint32_t end, const char* text) {
+  int64_t len = 0;
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL && text != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+  return_value_if_fail(!code_edit_is_readonly(code_edit), RET_FAIL);
+
+  len = SSM(SCI_GETTEXTLENGTH, 0, 0);
+  return_value_if_fail(len >= 0, RET_FAIL);
+
+  end = tk_min(end, len);
+  start = tk_min(start, end);
+  SSM(SCI_SETTARGETRANGE, start, end);
+  SSM(SCI_REPLACETARGET, strlen(text), (sptr_t)text);
+
+  return RET_OK;
+}
+
+ret_t code_edit_update_text(widget_t* widget, const char* text) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL && text != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+  return_value_if_fail(!code_edit_is_readonly(code_edit), RET_FAIL);
+
+  return impl->UpdateText(text, strlen(text));
+}
+
+ret_t code_edit_begin_batch(widget_t* widget) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+
+  impl->BeginBatch();
+
+  return RET_OK;
+}
+
+ret_t code_edit_end_batch(widget_t* widget) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+
+  impl->EndBatch();
+
+  return RET_OK;
+}
+
+ret_t code_edit_get_text_range(widget_t* widget, uint32_t start, uint32_t end, str_t* text) {
+  int64_t len = 0;
+  Sci_TextRange range;
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL && text != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+
+  len = SSM(SCI_GETTEXTLENGTH, 0, 0);
+  return_value_if_fail(len >= 0, RET_FAIL);
+
+  end = tk_min(end, len);
+  start = tk_min(start, end);
+  return_value_if_fail(str_extend(text, end - start + 1) == RET_OK, RET_OOM);
+
+  /*SCI_GETTEXTRANGE只复制指定的范围，并在末尾补上\0。*/
+  range.chrg.cpMin = start;
+  range.chrg.cpMax = end;
+  range.lpstrText = text->str;
+  SSM(SCI_GETTEXTRANGE, 0, (sptr_t)(&range));
+  text->size = end - start;
+
+  return RET_OK;
+}
+
+ret_t code_edit_get_line(widget_t* widget, uint32_t line, str_t* text) {
+  int64_t start = 0;
+  int64_t end = 0;
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL && text != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+  return_value_if_fail(line < (uint32_t)SSM(SCI_GETLINECOUNT, 0, 0), RET_BAD_PARAMS);
+
+  start = SSM(SCI_POSITIONFROMLINE, line, 0);
+  end = SSM(SCI_GETLINEENDPOSITION, line, 0);
+
+  return code_edit_get_text_range(widget, start, end, text);
+}
+
+uint32_t code_edit_get_line_count(widget_t* widget) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, 0);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, 0);
+
+  return SSM(SCI_GETLINECOUNT, 0, 0);
+}
+
+uint32_t code_edit_line_from_offset(widget_t* widget, uint32_t offset) {
+  sptr_t length = 0;
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, 0);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, 0);
+
+  /*行索引按int保存位置，先把偏移限制在文档范围内。*/
+  length = SSM(SCI_GETTEXTLENGTH, 0, 0);
+  if (offset > (uint64_t)length) {
+    offset = (uint32_t)length;
+  }
+
+  return SSM(SCI_LINEFROMPOSITION, offset, 0);
+}
+
+int32_t code_edit_offset_from_line(widget_t* widget, uint32_t line) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, -1);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, -1);
+
+  return SSM(SCI_POSITIONFROMLINE, line, 0);
+}
+
 ret_t code_edit_get_prop(widget_t* widget, const char* name, value_t* v) {
   code_edit_t* code_edit = CODE_EDIT(widget);
   return_value_if_fail(code_edit != NULL && name != NULL && v != NULL, RET_BAD_PARAMS);
@@ -339,7 +600,71 @@ ret_t code_edit_get_prop(widget_t* widget, const char* name, value_t* v) {
     value_set_uint32(v, code_edit->tab_width);
     return RET_OK;
   } else if (tk_str_eq(WIDGET_PROP_READONLY, name)) {
-    value_set_bool(v, code_edit->readonly);
+    value_set_bool(v, code_edit_is_readonly(code_edit));
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_ATOMIC_SAVE, name)) {
+    value_set_bool(v, code_edit->atomic_save);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_KEEP_BACKUP, name)) {
+    value_set_bool(v, code_edit->keep_backup);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_BACKGROUND_LEXING, name)) {
+    value_set_bool(v, code_edit->background_lexing);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_IDLE_STYLING, name)) {
+    value_set_uint32(v, code_edit->idle_styling);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_STYLING_BUDGET_US, name)) {
+    value_set_uint32(v, code_edit->styling_budget_us);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_LEX_THREADS, name)) {
+    value_set_uint32(v, code_edit->lex_threads);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_LEX_CHUNKS, name)) {
+    ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+    value_set_uint32(v, impl != NULL ? impl->GetLexChunks() : 0);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_SKIPPED_FRAMES, name)) {
+    ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+    value_set_uint32(v, impl != NULL ? impl->GetSkippedFrames() : 0);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_REDRAW_REQUESTS, name)) {
+    ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+    value_set_uint32(v, impl != NULL ? impl->GetRedrawRequests() : 0);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_PAINTED_LINES, name)) {
+    ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+    value_set_uint32(v, impl != NULL ? impl->GetLinesLaidOut() : 0);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_GENERATION, name)) {
+    ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+    value_set_uint32(v, impl != NULL ? impl->GetGeneration() : 0);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_FONT_SWITCHES, name)) {
+    ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+    value_set_uint32(v, impl != NULL ? impl->GetFrameStats().fontSwitches : 0);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_FILL_REQUESTS, name)) {
+    ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+    value_set_uint32(v, impl != NULL ? impl->GetFrameStats().fillRequests : 0);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_FILL_RECTS, name)) {
+    ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+    value_set_uint32(v, impl != NULL ? impl->GetFrameStats().fills : 0);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_FILLS_ELIDED, name)) {
+    ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+    value_set_uint32(v, impl != NULL ? impl->GetFrameStats().fillsElided : 0);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_FONT_CACHE_HITS, name)) {
+    FontCacheStats stats;
+    Scintilla::FontCacheGetStats(&stats);
+    value_set_uint32(v, stats.hits);
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_FONT_CACHE_MISSES, name)) {
+    FontCacheStats stats;
+    Scintilla::FontCacheGetStats(&stats);
+    value_set_uint32(v, stats.misses);
     return RET_OK;
   }
 
@@ -379,6 +704,24 @@ ret_t code_edit_set_prop(widget_t* widget, const char* name, const value_t* v) {
   } else if (tk_str_eq(WIDGET_PROP_READONLY, name)) {
     code_edit_set_readonly(widget, value_bool(v));
     return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_ATOMIC_SAVE, name)) {
+    code_edit_set_atomic_save(widget, value_bool(v));
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_KEEP_BACKUP, name)) {
+    code_edit_set_keep_backup(widget, value_bool(v));
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_BACKGROUND_LEXING, name)) {
+    code_edit_set_background_lexing(widget, value_bool(v));
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_IDLE_STYLING, name)) {
+    code_edit_set_idle_styling(widget, value_uint32(v));
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_STYLING_BUDGET_US, name)) {
+    code_edit_set_styling_budget_us(widget, value_uint32(v));
+    return RET_OK;
+  } else if (tk_str_eq(CODE_EDIT_PROP_LEX_THREADS, name)) {
+    code_edit_set_lex_threads(widget, value_uint32(v));
+    return RET_OK;
   }
 
   return RET_NOT_FOUND;
@@ -392,6 +735,7 @@ ret_t code_edit_on_destroy(widget_t* widget) {
   widget_off_by_func(window_manager(), EVT_THEME_CHANGED, on_code_edit_apply_lang_theme,
                      (void*)widget);
 
+  code_edit_cancel_load(widget);
   TKMEM_FREE(code_edit->lang);
   TKMEM_FREE(code_edit->code_theme);
   TKMEM_FREE(code_edit->filename);
@@ -449,16 +793,22 @@ ret_t code_edit_on_event(widget_t* widget, event_t* e) {
       break;
     }
     case EVT_BLUR: {
-      value_change_event_t evt;
-
       input_method_request(input_method(), NULL);
-      value_set_wstr(&(evt.old_value), NULL);
-      value_set_wstr(&(evt.new_value), widget->text.str);
-      widget_dispatch(widget, (event_t*)&evt);
+
+      /*获得焦点后文本有变化时，失去焦点时再触发一次EVT_VALUE_CHANGED，new_value为当前的全部文本。*/
+      if (code_edit->focus_generation != impl->GetGeneration()) {
+        value_change_event_t evt;
+
+        value_change_event_init(&evt, EVT_VALUE_CHANGED, widget);
+        code_edit_get_text(widget, &(evt.new_value));
+        code_edit->focus_generation = impl->GetGeneration();
+        widget_dispatch(widget, (event_t*)&evt);
+      }
       break;
     }
     case EVT_FOCUS: {
       input_method_request(input_method(), widget);
+      code_edit->focus_generation = impl->GetGeneration();
       break;
     }
     case EVT_IM_COMMIT: {
@@ -514,16 +864,6 @@ ret_t code_edit_on_add_child(widget_t* widget, widget_t* child) {
   return RET_CONTINUE;
 }
 
-static ret_t code_edit_on_invalidate_idle(const idle_info_t* idle) {
-  widget_t* widget = WIDGET(idle->ctx);
-  return_value_if_fail(widget != NULL, RET_BAD_PARAMS);
-
-  if (widget->visible && widget->opacity > 0x08 && widget->w > 0 && widget->h > 0) {
-    widget_invalidate(widget, NULL);
-  }
-  return RET_REPEAT;
-}
-
 extern "C" widget_t* code_edit_create_internal(widget_t* parent, xy_t x, xy_t y, wh_t w, wh_t h);
 
 widget_t* code_edit_create(widget_t* parent, xy_t x, xy_t y, wh_t w, wh_t h) {
@@ -531,11 +871,13 @@ widget_t* code_edit_create(widget_t* parent, xy_t x, xy_t y, wh_t w, wh_t h) {
   code_edit_t* code_edit = CODE_EDIT(widget);
   return_value_if_fail(code_edit != NULL, NULL);
   code_edit->impl = new (std::nothrow) ScintillaAWTK(widget);
+  if (code_edit->impl != NULL) {
+    static_cast<ScintillaAWTK*>(code_edit->impl)
+        ->SetListener(new (std::nothrow) CodeEditListener(widget));
+  }
 
   widget_on(window_manager(), EVT_THEME_CHANGED, on_code_edit_apply_lang_theme, (void*)widget);
 
-  widget_add_idle(widget, code_edit_on_invalidate_idle);
-
   code_edit_set_tab_width(widget, 4);
   code_edit_set_zoom(widget, 5);
   code_edit_set_scroll_line(widget, 1);
@@ -575,13 +917,22 @@ static ret_t code_edit_get_text(widget_t* widget, value_t* v) {
   return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
 
   value_set_str(v, NULL);
+  str = &(code_edit->text);
+
+  /*文档没有变化时直接返回上次的快照，不再复制整个文档。*/
+  if (code_edit->text_generation == impl->GetGeneration() && str->str != NULL) {
+    value_set_str(v, str->str);
+    return RET_OK;
+  }
+
   len = SSM(SCI_GETTEXTLENGTH, 0, 0);
   return_value_if_fail(len >= 0, RET_FAIL);
-  str = &(code_edit->text);
   return_value_if_fail(str_extend(str, len + 1) == RET_OK, RET_FAIL);
 
   str_set(str, "");
   SSM(SCI_GETTEXT, len + 1, (sptr_t)(str->str));
+  str->size = len;
+  code_edit->text_generation = impl->GetGeneration();
   value_set_str(v, str->str);
 
   return RET_OK;
@@ -596,9 +947,16 @@ static ret_t code_edit_set_text(widget_t* widget, const value_t* v) {
   return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
 
   str = &(code_edit->text);
+  code_edit->text_generation = 0;
   return_value_if_fail(str_from_value(str, v) == RET_OK, RET_FAIL);
 
+  /*映射的文档不能修改，换成新的文档，解除映射并恢复只读和语法高亮的设置。*/
+  if (code_edit->mapped) {
+    return_value_if_fail(code_edit_unmap_document(widget) == RET_OK, RET_OOM);
+  }
+
   SSM(SCI_SETTEXT, 0, (sptr_t)(str->str));
+  impl->RequestBackgroundLexing();
 
   return RET_OK;
 }
@@ -661,54 +1019,366 @@ bool_t code_edit_can_paste(widget_t* widget) {
 
 static const uint8_t s_utf8_bom[3] = {0xEF, 0xBB, 0xBF};
 
+/*流式读写文件时每次读写的字节数。*/
+#define CODE_EDIT_IO_CHUNK_SIZE (64 * 1024)
+
+/*映射文件时每次空闲处理建立行索引的字节数。*/
+#define CODE_EDIT_INDEX_CHUNK_SIZE (1024 * 1024)
+
+static ret_t code_edit_write_range(ScintillaAWTK* impl, fs_file_t* fp, Sci::Position start,
+                                   Sci::Position end) {
+  const char* data = NULL;
+  Sci::Position size = end - start;
+
+  if (size <= 0) {
+    return RET_OK;
+  }
+
+  /*范围不跨越间隙时，SCI_GETRANGEPOINTER直接返回文档缓冲区中的指针，不会移动数据。*/
+  data = (const char*)SSM(SCI_GETRANGEPOINTER, start, size);
+  return_value_if_fail(data != NULL, RET_FAIL);
+
+  while (size > 0) {
+    int32_t len = fs_file_write(fp, data, tk_min(size, CODE_EDIT_IO_CHUNK_SIZE));
+    return_value_if_fail(len > 0, RET_IO);
+
+    data += len;
+    size -= len;
+  }
+
+  return RET_OK;
+}
+
+static ret_t code_edit_write_file(ScintillaAWTK* impl, fs_file_t* fp, bool_t with_utf8_bom) {
+  ret_t ret = RET_OK;
+  Sci::Position gap = 0;
+  Sci::Position len = 0;
+
+  if (with_utf8_bom) {
+    if (fs_file_write(fp, s_utf8_bom, sizeof(s_utf8_bom)) != sizeof(s_utf8_bom)) {
+      return RET_IO;
+    }
+  }
+
+  /*文档缓冲区以间隙为界分为两段，分别直接写入文件，不复制整个文档。*/
+  len = SSM(SCI_GETLENGTH, 0, 0);
+  gap = SSM(SCI_GETGAPPOSITION, 0, 0);
+  ret = code_edit_write_range(impl, fp, 0, gap);
+  if (ret == RET_OK) {
+    ret = code_edit_write_range(impl, fp, gap, len);
+  }
+
+  return ret;
+}
+
+/*在filename后加上后缀生成同一目录下的文件名，路径太长被截断时返回失败。*/
+static ret_t code_edit_sibling_filename(char* result, uint32_t size, const char* filename,
+                                        const char* suffix) {
+  int32_t len = tk_snprintf(result, size, "%s%s", filename, suffix);
+
+  return (len >= 0 && (uint32_t)len < size) ? RET_OK : RET_BAD_PARAMS;
+}
+
+/*临时文件名带上时间和序号，避免与其它编辑器或进程正在保存的临时文件冲突。*/
+static ret_t code_edit_temp_filename(char* result, uint32_t size, const char* filename) {
+  static uint32_t s_seq = 0;
+
+  for (uint32_t i = 0; i < 100; i++) {
+    char suffix[64];
+
+    tk_snprintf(suffix, sizeof(suffix), ".%u.%u.tmp", (uint32_t)time_now_ms(), ++s_seq);
+    return_value_if_fail(code_edit_sibling_filename(result, size, filename, suffix) == RET_OK,
+                         RET_BAD_PARAMS);
+    if (!fs_file_exist(os_fs(), result)) {
+      return RET_OK;
+    }
+  }
+
+  return RET_FAIL;
+}
+
+/*重命名要在所在目录同步到存储设备后才不会因掉电丢失。不能以文件方式打开目录的平台跳过这一步。*/
+static ret_t code_edit_sync_dir(const char* filename) {
+  ret_t ret = RET_OK;
+  fs_file_t* fp = NULL;
+  char dirname[MAX_PATH + 1];
+
+  if (path_dirname(filename, dirname, sizeof(dirname)) != RET_OK || *dirname == '\0') {
+    tk_strncpy(dirname, ".", sizeof(dirname) - 1);
+  }
+
+  fp = fs_open_file(os_fs(), dirname, "rb");
+  if (fp != NULL) {
+    ret = fs_file_sync(fp);
+    fs_file_close(fp);
+  }
+
+  return ret;
+}
+
+/*
+ * 把原文件的权限和属主复制到新文件上，以免原子保存后变为临时文件的缺省权限。非特权进程不能把
+ * 属主改为其它用户，这时保留新文件的属主。Windows下没有对应的权限位，不需要复制。
+ */
+static ret_t code_edit_copy_mode(const char* from, const char* to) {
+#ifndef WIN32
+  struct stat st;
+
+  if (stat(from, &st) != 0) {
+    return RET_OK;
+  }
+
+  return_value_if_fail(chmod(to, st.st_mode & 07777) == 0, RET_IO);
+  if (chown(to, st.st_uid, st.st_gid) != 0) {
+    log_debug("keep owner of %s\n", to);
+  }
+#endif /*WIN32*/
+
+  return RET_OK;
+}
+
+/*复制文件并同步到存储设备，fs_copy_file不同步，掉电后备份可能不完整。*/
+static ret_t code_edit_copy_file(const char* from, const char* to) {
+  ret_t ret = RET_OK;
+  char* buff = NULL;
+  fs_file_t* src = NULL;
+  fs_file_t* dst = NULL;
+
+  buff = (char*)TKMEM_ALLOC(CODE_EDIT_IO_CHUNK_SIZE);
+  return_value_if_fail(buff != NULL, RET_OOM);
+  src = fs_open_file(os_fs(), from, "rb");
+  dst = src != NULL ? fs_open_file(os_fs(), to, "wb") : NULL;
+
+  if (src == NULL || dst == NULL) {
+    ret = RET_IO;
+  }
+
+  while (ret == RET_OK) {
+    int32_t len = fs_file_read(src, buff, CODE_EDIT_IO_CHUNK_SIZE);
+    if (len <= 0) {
+      ret = len == 0 ? RET_OK : RET_IO;
+      break;
+    }
+    if (fs_file_write(dst, buff, len) != len) {
+      ret = RET_IO;
+    }
+  }
+
+  if (ret == RET_OK) {
+    ret = fs_file_sync(dst);
+  }
+  if (dst != NULL) {
+    fs_file_close(dst);
+  }
+  if (src != NULL) {
+    fs_file_close(src);
+  }
+  TKMEM_FREE(buff);
+
+  if (ret == RET_OK) {
+    ret = code_edit_copy_mode(from, to);
+  }
+
+  return ret;
+}
+
+static ret_t code_edit_replace_file(const char* tmp_filename, const char* filename,
+                                    bool_t keep_backup) {
+  fs_t* fs = os_fs();
+
+  /*备份是原文件的副本，替换前原文件始终存在。*/
+  if (keep_backup && fs_file_exist(fs, filename)) {
+    char bak_filename[MAX_PATH + 1];
+    return_value_if_fail(code_edit_sibling_filename(bak_filename, sizeof(bak_filename), filename,
+                                                    ".bak") == RET_OK,
+                         RET_BAD_PARAMS);
+    return_value_if_fail(code_edit_copy_file(filename, bak_filename) == RET_OK, RET_IO);
+  }
+
+  return_value_if_fail(code_edit_copy_mode(filename, tmp_filename) == RET_OK, RET_IO);
+
+  /*临时文件一次重命名覆盖原文件，任何时刻原文件要么是旧内容要么是新内容。*/
+  return_value_if_fail(fs_file_rename(fs, tmp_filename, filename) == RET_OK, RET_IO);
+
+  return code_edit_sync_dir(filename);
+}
+
+static ret_t code_edit_save_atomic(widget_t* widget, const char* filename, bool_t with_utf8_bom) {
+  ret_t ret = RET_OK;
+  fs_file_t* fp = NULL;
+  char tmp_filename[MAX_PATH + 1];
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+
+  /*先完整写入同目录下的临时文件并同步到存储设备，原文件在替换前始终保持完整。*/
+  ret = code_edit_temp_filename(tmp_filename, sizeof(tmp_filename), filename);
+  return_value_if_fail(ret == RET_OK, ret);
+  fp = fs_open_file(os_fs(), tmp_filename, "wb");
+  return_value_if_fail(fp != NULL, RET_FAIL);
+
+  ret = code_edit_write_file(impl, fp, with_utf8_bom);
+  if (ret == RET_OK) {
+    ret = fs_file_sync(fp);
+  }
+  fs_file_close(fp);
+
+  if (ret == RET_OK) {
+    ret = code_edit_replace_file(tmp_filename, filename, code_edit->keep_backup);
+  }
+
+  if (ret != RET_OK) {
+    fs_remove_file(os_fs(), tmp_filename);
+  }
+
+  return ret;
+}
+
 ret_t code_edit_save(widget_t* widget, const char* filename, bool_t with_utf8_bom) {
-  value_t v;
-  int32_t size = 0;
+  ret_t ret = RET_OK;
   fs_file_t* fp = NULL;
-  const char* str = NULL;
+  ScintillaAWTK* impl = NULL;
   code_edit_t* code_edit = CODE_EDIT(widget);
   return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
   filename = filename != NULL ? filename : code_edit->filename;
   return_value_if_fail(filename != NULL, RET_BAD_PARAMS);
-  return_value_if_fail(code_edit_get_text(widget, &v) == RET_OK, RET_BAD_PARAMS);
 
-  str = value_str(&v);
-  return_value_if_fail(str != NULL, RET_BAD_PARAMS);
+  if (code_edit->atomic_save) {
+    return code_edit_save_atomic(widget, filename, with_utf8_bom);
+  }
 
   fp = fs_open_file(os_fs(), filename, "w+");
   return_value_if_fail(fp != NULL, RET_FAIL);
 
-  if (with_utf8_bom) {
-    ENSURE(fs_file_write(fp, s_utf8_bom, sizeof(s_utf8_bom)) == sizeof(s_utf8_bom));
-  }
-  size = strlen(str);
-  ENSURE(fs_file_write(fp, str, size) == size);
+  ret = code_edit_write_file(impl, fp, with_utf8_bom);
   fs_file_close(fp);
 
+  return ret;
+}
+
+static ret_t code_edit_attach_document(widget_t* widget, void* doc, bool_t mapped) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL && doc != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+
+  /*编码、TAB宽度、只读和词法分析器(包括它的属性和关键字)是文档的属性，替换文档后需要重新设置。*/
+  impl->AttachDocument(doc);
+  SSM(SCI_RELEASEDOCUMENT, 0, (sptr_t)doc);
+  SSM(SCI_SETCODEPAGE, SC_CP_UTF8, 0);
+  SSM(SCI_SETTABWIDTH, code_edit->tab_width, 0);
+  SSM(SCI_SETUNDOCOLLECTION, 1, 0);
+  SSM(SCI_EMPTYUNDOBUFFER, 0, 0);
+  SSM(SCI_SETSAVEPOINT, 0, 0);
+  code_edit->mapped = mapped;
+  SSM(SCI_SETREADONLY, code_edit_is_readonly(code_edit), 0);
+  impl->NotifyTextChanged(0, -1, NULL, -1);
+  impl->NotifyChange();
+  impl->RequestBackgroundLexing();
+
+  return RET_OK;
+}
+
+static ret_t code_edit_unmap_document(widget_t* widget) {
+  void* doc = NULL;
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+
+  /*还在建立索引时先停止，再换成新的空文档。*/
+  code_edit_cancel_load(widget);
+  doc = (void*)SSM(SCI_CREATEDOCUMENT, 0, SC_DOCUMENTOPTION_DEFAULT);
+  return_value_if_fail(doc != NULL, RET_OOM);
+  code_edit_attach_document(widget, doc, FALSE);
+  code_edit_apply_lang_theme(widget);
+
   return RET_OK;
 }
 
+typedef ret_t (*code_edit_on_chunk_t)(void* ctx, uint32_t size);
+
+static ret_t code_edit_load_to_loader(fs_file_t* fp, ILoader* loader, code_edit_on_chunk_t on_chunk,
+                                      void* ctx) {
+  char* buff = NULL;
+  int32_t len = 0;
+  bool_t first = TRUE;
+  ret_t ret = RET_OK;
+  return_value_if_fail(fp != NULL && loader != NULL, RET_BAD_PARAMS);
+
+  buff = (char*)TKMEM_ALLOC(CODE_EDIT_IO_CHUNK_SIZE);
+  return_value_if_fail(buff != NULL, RET_OOM);
+
+  /*按块读取文件直接追加到文档中，不需要把整个文件读到内存里。*/
+  while ((len = fs_file_read(fp, buff, CODE_EDIT_IO_CHUNK_SIZE)) > 0) {
+    const char* data = buff;
+
+    if (first) {
+      first = FALSE;
+      if (len >= (int32_t)sizeof(s_utf8_bom) && memcmp(data, s_utf8_bom, sizeof(s_utf8_bom)) == 0) {
+        data += sizeof(s_utf8_bom);
+        len -= sizeof(s_utf8_bom);
+      }
+    }
+
+    if (loader->AddData(data, len) != SC_STATUS_OK) {
+      ret = RET_OOM;
+      break;
+    }
+
+    if (on_chunk != NULL && on_chunk(ctx, len) != RET_OK) {
+      ret = RET_STOP;
+      break;
+    }
+  }
+
+  if (len < 0) {
+    ret = RET_IO;
+  }
+
+  TKMEM_FREE(buff);
+
+  return ret;
+}
+
 ret_t code_edit_load(widget_t* widget, const char* filename) {
-  value_t v;
-  uint32_t size = 0;
-  const char* str = NULL;
-  const char* data = NULL;
+  ret_t ret = RET_OK;
+  int32_t size = 0;
+  fs_file_t* fp = NULL;
+  ILoader* loader = NULL;
+  ScintillaAWTK* impl = NULL;
   code_edit_t* code_edit = CODE_EDIT(widget);
   return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
   filename = filename != NULL ? filename : code_edit->filename;
   return_value_if_fail(filename != NULL, RET_BAD_PARAMS);
 
-  data = (const char*)file_read(filename, &size);
-  return_value_if_fail(data != NULL, RET_BAD_PARAMS);
+  code_edit_cancel_load(widget);
+  size = fs_get_file_size(os_fs(), filename);
+  fp = fs_open_file(os_fs(), filename, "rb");
+  return_value_if_fail(fp != NULL, RET_BAD_PARAMS);
 
-  if (memcmp(data, s_utf8_bom, sizeof(s_utf8_bom)) == 0) {
-    str = data + 3;
-  } else {
-    str = data;
+  /*预先按文件大小分配文档的缓冲区，加载过程中不再重新分配。*/
+  loader = ScintillaAWTK::CreateLoader(tk_max(size, 0), SC_DOCUMENTOPTION_DEFAULT);
+  if (loader == NULL) {
+    fs_file_close(fp);
+    return RET_OOM;
   }
 
-  value_set_str(&v, str);
-  if (code_edit_set_text(widget, &v) == RET_OK) {
+  ret = code_edit_load_to_loader(fp, loader, NULL, NULL);
+  fs_file_close(fp);
+
+  if (ret != RET_OK) {
+    loader->Release();
+    return ret;
+  }
+
+  ret = code_edit_attach_document(widget, loader->ConvertToDocument(), FALSE);
+  if (ret == RET_OK) {
     const char* lang = strrchr(filename, '.');
     if (lang != NULL) {
       lang++;
@@ -716,11 +1386,288 @@ ret_t code_edit_load(widget_t* widget, const char* filename) {
     }
   }
 
-  TKMEM_FREE(data);
+  return ret;
+}
+
+/*后台加载文件的状态。loaded/canceled/finished/result由lock保护，fp和loader在线程结束前归工作线程使用。
+ *映射文件时没有工作线程，文档已经显示，在UI线程的空闲处理中分步建立行索引，loaded是已经索引的字节数。*/
+typedef struct _code_edit_async_load_t {
+  widget_t* widget;
+  char* filename;
+  fs_file_t* fp;
+  ILoader* loader;
+  tk_thread_t* thread;
+  tk_mutex_t* lock;
+  uint32_t idle_id;
+  uint32_t percent;
+  int32_t size;
+
+  int32_t loaded;
+  bool_t canceled;
+  bool_t finished;
+  ret_t result;
+} code_edit_async_load_t;
+
+static ret_t code_edit_async_load_destroy(code_edit_async_load_t* load) {
+  if (load->idle_id != TK_INVALID_ID) {
+    idle_remove(load->idle_id);
+  }
+
+  if (load->thread != NULL) {
+    tk_thread_join(load->thread);
+    tk_thread_destroy(load->thread);
+  }
+
+  if (load->loader != NULL) {
+    load->loader->Release();
+  }
+
+  if (load->fp != NULL) {
+    fs_file_close(load->fp);
+  }
+
+  if (load->lock != NULL) {
+    tk_mutex_destroy(load->lock);
+  }
+
+  TKMEM_FREE(load->filename);
+  TKMEM_FREE(load);
 
   return RET_OK;
 }
 
+static ret_t code_edit_async_load_on_chunk(void* ctx, uint32_t size) {
+  bool_t canceled = FALSE;
+  code_edit_async_load_t* load = (code_edit_async_load_t*)ctx;
+
+  tk_mutex_lock(load->lock);
+  load->loaded += size;
+  canceled = load->canceled;
+  tk_mutex_unlock(load->lock);
+
+  return canceled ? RET_STOP : RET_OK;
+}
+
+static void* code_edit_async_load_thread(void* args) {
+  code_edit_async_load_t* load = (code_edit_async_load_t*)args;
+
+  ret_t ret = RET_OOM;
+
+  /*分配缓冲区和读取文件都在工作线程中进行，当前文档仍由UI线程使用。*/
+  load->loader = ScintillaAWTK::CreateLoader(tk_max(load->size, 0), SC_DOCUMENTOPTION_DEFAULT);
+  if (load->loader != NULL) {
+    ret = code_edit_load_to_loader(load->fp, load->loader, code_edit_async_load_on_chunk, load);
+  }
+
+  tk_mutex_lock(load->lock);
+  load->result = ret;
+  load->finished = TRUE;
+  tk_mutex_unlock(load->lock);
+
+  return NULL;
+}
+
+static ret_t code_edit_async_load_progress(code_edit_async_load_t* load, int32_t loaded) {
+  progress_event_t evt;
+  uint32_t percent = load->size > 0 ? (uint32_t)((int64_t)loaded * 100 / load->size) : 0;
+  percent = tk_min(percent, 99);
+
+  if (percent != load->percent) {
+    load->percent = percent;
+    widget_dispatch(load->widget, progress_event_init(&evt, percent));
+  }
+
+  return RET_OK;
+}
+
+static ret_t code_edit_mapped_load_on_idle(const idle_info_t* info) {
+  progress_event_t evt;
+  Sci::Position indexed = 0;
+  code_edit_async_load_t* load = (code_edit_async_load_t*)(info->ctx);
+  widget_t* widget = load->widget;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+
+  /*映射期间文件被截断时，访问文件末尾之后的页面会触发SIGBUS，每次建立索引前检查，变短时立即解除映射。*/
+  if (fs_get_file_size(os_fs(), load->filename) < load->size) {
+    load->idle_id = TK_INVALID_ID;
+    code_edit_unmap_document(widget);
+    widget_dispatch_simple_event(widget, EVT_ERROR);
+
+    return RET_REMOVE;
+  }
+
+  indexed = impl->IndexMappedText(CODE_EDIT_INDEX_CHUNK_SIZE);
+  if (indexed > load->loaded) {
+    load->loaded = (int32_t)indexed;
+    code_edit_async_load_progress(load, load->loaded);
+
+    return RET_REPEAT;
+  }
+
+  load->idle_id = TK_INVALID_ID;
+  code_edit->async_load = NULL;
+  code_edit_async_load_destroy(load);
+  widget_dispatch(widget, progress_event_init(&evt, 100));
+  widget_dispatch_simple_event(widget, EVT_DONE);
+
+  return RET_REMOVE;
+}
+
+static ret_t code_edit_async_load_on_idle(const idle_info_t* info) {
+  ret_t result = RET_OK;
+  int32_t loaded = 0;
+  bool_t finished = FALSE;
+  code_edit_async_load_t* load = (code_edit_async_load_t*)(info->ctx);
+  widget_t* widget = load->widget;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+
+  tk_mutex_lock(load->lock);
+  loaded = load->loaded;
+  finished = load->finished;
+  result = load->result;
+  tk_mutex_unlock(load->lock);
+
+  if (!finished) {
+    code_edit_async_load_progress(load, loaded);
+
+    return RET_REPEAT;
+  }
+
+  /*文档在UI线程中替换，替换只交换指针，不会复制文本。*/
+  load->idle_id = TK_INVALID_ID;
+  code_edit->async_load = NULL;
+
+  if (result == RET_OK) {
+    progress_event_t evt;
+    ILoader* loader = load->loader;
+    const char* lang = strrchr(load->filename, '.');
+
+    load->loader = NULL;
+    code_edit_attach_document(widget, loader->ConvertToDocument(), FALSE);
+    if (lang != NULL) {
+      code_edit_set_lang(widget, lang + 1);
+    }
+
+    widget_dispatch(widget, progress_event_init(&evt, 100));
+    code_edit_async_load_destroy(load);
+    widget_dispatch_simple_event(widget, EVT_DONE);
+  } else {
+    code_edit_async_load_destroy(load);
+    widget_dispatch_simple_event(widget, EVT_ERROR);
+  }
+
+  return RET_REMOVE;
+}
+
+static ret_t code_edit_start_load(widget_t* widget, const char* filename, bool_t mapped) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_async_load_t* load = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+  filename = filename != NULL ? filename : code_edit->filename;
+  return_value_if_fail(filename != NULL, RET_BAD_PARAMS);
+
+  code_edit_cancel_load(widget);
+
+  load = TKMEM_ZALLOC(code_edit_async_load_t);
+  return_value_if_fail(load != NULL, RET_OOM);
+
+  load->widget = widget;
+  load->idle_id = TK_INVALID_ID;
+  load->filename = tk_strdup(filename);
+  load->size = fs_get_file_size(os_fs(), filename);
+  load->lock = tk_mutex_create();
+  goto_error_if_fail(load->filename != NULL && load->lock != NULL);
+
+  if (mapped) {
+    ILoader* loader = NULL;
+
+    load->idle_id = idle_add(code_edit_mapped_load_on_idle, load);
+    goto_error_if_fail(load->idle_id != TK_INVALID_ID);
+    loader = ScintillaAWTK::CreateMappedLoader(filename);
+    goto_error_if_fail(loader != NULL);
+
+    /*映射的文档立即显示，先索引第一块，其余的在空闲时追加，只访问到的页面才会读入内存。*/
+    code_edit_attach_document(widget, loader->ConvertToDocument(), TRUE);
+    SSM(SCI_SETLEXER, SCLEX_NULL, 0);
+    load->loaded = (int32_t)(impl->IndexMappedText(CODE_EDIT_IO_CHUNK_SIZE));
+    code_edit->async_load = load;
+
+    return RET_OK;
+  }
+
+  load->fp = fs_open_file(os_fs(), filename, "rb");
+  goto_error_if_fail(load->fp != NULL);
+
+  load->idle_id = idle_add(code_edit_async_load_on_idle, load);
+  goto_error_if_fail(load->idle_id != TK_INVALID_ID);
+
+  load->thread = tk_thread_create(code_edit_async_load_thread, load);
+  goto_error_if_fail(load->thread != NULL);
+  if (tk_thread_start(load->thread) != RET_OK) {
+    tk_thread_destroy(load->thread);
+    load->thread = NULL;
+    goto error;
+  }
+
+  code_edit->async_load = load;
+
+  return RET_OK;
+error:
+  code_edit_async_load_destroy(load);
+  return RET_FAIL;
+}
+
+ret_t code_edit_load_async(widget_t* widget, const char* filename) {
+  return code_edit_start_load(widget, filename, FALSE);
+}
+
+ret_t code_edit_load_mapped(widget_t* widget, const char* filename) {
+  return code_edit_start_load(widget, filename, TRUE);
+}
+
+ret_t code_edit_cancel_load(widget_t* widget) {
+  code_edit_async_load_t* load = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, RET_BAD_PARAMS);
+
+  load = (code_edit_async_load_t*)(code_edit->async_load);
+  if (load != NULL) {
+    tk_mutex_lock(load->lock);
+    load->canceled = TRUE;
+    tk_mutex_unlock(load->lock);
+
+    /*工作线程每读完一块检查一次取消标志，最多等待分配缓冲区或读取一块的时间。
+     *映射文件时只是停止建立索引，已经索引的部分仍然显示。*/
+    code_edit->async_load = NULL;
+    code_edit_async_load_destroy(load);
+  }
+
+  return RET_OK;
+}
+
+bool_t code_edit_is_loading(widget_t* widget) {
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL, FALSE);
+
+  return code_edit->async_load != NULL;
+}
+
 bool_t code_edit_is_modified(widget_t* widget) {
   return code_edit_cmd_bool_void(widget, SCI_GETMODIFY);
 }
+
+ret_t code_edit_get_dirty_rect(widget_t* widget, rect_t* r, bool_t reset) {
+  ScintillaAWTK* impl = NULL;
+  code_edit_t* code_edit = CODE_EDIT(widget);
+  return_value_if_fail(code_edit != NULL && r != NULL, RET_BAD_PARAMS);
+  impl = static_cast<ScintillaAWTK*>(code_edit->impl);
+  return_value_if_fail(impl != NULL, RET_BAD_PARAMS);
+
+  impl->GetDamage(r, reset);
+
+  return RET_OK;
+}
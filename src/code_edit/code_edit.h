@@ -117,9 +117,55 @@ typedef struct _code_edit_t {
    */
   int32_t zoom;
 
+  /**
+   * @property {bool_t} atomic_save
+   * @annotation ["set_prop","get_prop","readable","persitent","design","scriptable"]
+   * 保存时是否先写入临时文件，同步到存储设备后再替换原文件(保存过程中掉电不会损坏原文件)。
+   */
+  bool_t atomic_save;
+
+  /**
+   * @property {bool_t} keep_backup
+   * @annotation ["set_prop","get_prop","readable","persitent","design","scriptable"]
+   * 原子保存时是否把原文件保留为同名的.bak文件。
+   */
+  bool_t keep_backup;
+
+  /**
+   * @property {bool_t} background_lexing
+   * @annotation ["set_prop","get_prop","readable","persitent","design","scriptable"]
+   * 是否在后台线程中对整个文档做词法分析(适合很大的文件，小文件仍在UI线程中分析)。
+   */
+  bool_t background_lexing;
+
+  /**
+   * @property {uint32_t} idle_styling
+   * @annotation ["set_prop","get_prop","readable","persitent","design","scriptable"]
+   * 空闲时的样式分析策略(0:none 1:to\_visible 2:after\_visible 3:all，同SC\_IDLESTYLING\_*)。
+   */
+  uint32_t idle_styling;
+
+  /**
+   * @property {uint32_t} styling_budget_us
+   * @annotation ["set_prop","get_prop","readable","persitent","design","scriptable"]
+   * 每次受限样式分析允许的时间(微秒)，0表示使用默认值(滚动时5ms，其它情况20ms)。
+   */
+  uint32_t styling_budget_us;
+
+  /**
+   * @property {uint32_t} lex_threads
+   * @annotation ["set_prop","get_prop","readable","persitent","design","scriptable"]
+   * 后台词法分析时并行分析使用的线程数，0表示按CPU核数，1表示不并行分析。
+   */
+  uint32_t lex_threads;
+
   /*private*/
   void* impl;
   str_t text;
+  uint32_t text_generation;
+  void* async_load;
+  bool_t mapped;
+  uint32_t focus_generation;
 } code_edit_t;
 
 /**
@@ -245,6 +291,86 @@ ret_t code_edit_set_wrap_word(widget_t* widget, bool_t wrap_word);
  */
 ret_t code_edit_set_scroll_line(widget_t* widget, int32_t scroll_line);
 
+/**
+ * @method code_edit_set_atomic_save
+ * 设置 是否原子保存。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {bool_t} atomic_save 是否原子保存。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_set_atomic_save(widget_t* widget, bool_t atomic_save);
+
+/**
+ * @method code_edit_set_keep_backup
+ * 设置 原子保存时是否保留.bak文件。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {bool_t} keep_backup 是否保留.bak文件。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_set_keep_backup(widget_t* widget, bool_t keep_backup);
+
+/**
+ * @method code_edit_set_background_lexing
+ * 设置 是否在后台线程中做词法分析。
+ *
+ * > 启用后，加载文件、设置文本或切换语言时在工作线程中对文档的快照做词法分析，完成后在UI线程中
+ * > 合并样式。分析期间文档被修改时结果作废，仍由UI线程按需分析可见的部分。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {bool_t} background_lexing 是否在后台线程中做词法分析。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_set_background_lexing(widget_t* widget, bool_t background_lexing);
+
+/**
+ * @method code_edit_set_idle_styling
+ * 设置 空闲时的样式分析策略。
+ *
+ * > 0(none)：绘制时同步分析到可见区域的末尾，不在空闲时分析。
+ * > 1(to\_visible)：绘制时只分析预算内的行，剩余的可见部分在空闲时分析。
+ * > 2(after\_visible)：绘制时同步分析可见区域，之后在空闲时按预算分析到文档末尾。
+ * > 3(all)：绘制时和空闲时都按预算分析，空闲时一直分析到文档末尾。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {uint32_t} idle_styling 空闲时的样式分析策略。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_set_idle_styling(widget_t* widget, uint32_t idle_styling);
+
+/**
+ * @method code_edit_set_styling_budget_us
+ * 设置 每次受限样式分析允许的时间。
+ *
+ * > 预算只对按预算分析的情况有效(见idle\_styling)，实际分析的行数按最近测得的每行耗时估算。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {uint32_t} styling_budget_us 允许的时间(微秒)，0表示使用默认值。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_set_styling_budget_us(widget_t* widget, uint32_t styling_budget_us);
+
+/**
+ * @method code_edit_set_lex_threads
+ * 设置 后台词法分析时并行分析使用的线程数。
+ *
+ * > 只对启用了background\_lexing的1MB以上的文档有效，而且词法分析器的状态要都保存在文档中
+ * > (目前有cpp、python、json、props以及其它简单的词法分析器)。文档在空行处分块，各块在
+ * > 不同的线程中分析，再从接缝处向后重新分析到结果对齐为止，无法对齐时仍然顺序分析。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {uint32_t} lex_threads 线程数，0表示按CPU核数。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_set_lex_threads(widget_t* widget, uint32_t lex_threads);
+
 /**
  * @method code_edit_insert_text
  * 插入一段文本。
@@ -257,6 +383,116 @@ ret_t code_edit_set_scroll_line(widget_t* widget, int32_t scroll_line);
  */
 ret_t code_edit_insert_text(widget_t* widget, uint32_t offset, const char* text);
 
+/**
+ * @method code_edit_replace_text
+ * 替换指定范围的文本(作为一个撤销步骤)。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {uint32_t} start 起始偏移位置。
+ * @param {uint32_t} end 结束偏移位置(不包括)。
+ * @param {const char*} text 新的文本。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_replace_text(widget_t* widget, uint32_t start, uint32_t end, const char* text);
+
+/**
+ * @method code_edit_update_text
+ * 用新的文本更新文档。
+ *
+ * > 与设置text属性不同，这里按行比较新旧文本，只修改有差异的行，所有修改合并为一个撤销步骤，
+ * > 撤销记录、光标和滚动位置都会保留，只有变化的部分需要重新做词法分析和排版。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {const char*} text 新的文本。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_update_text(widget_t* widget, const char* text);
+
+/**
+ * @method code_edit_begin_batch
+ * 开始批量修改。
+ *
+ * > 在code\_edit\_end\_batch之前的修改合并为一个撤销步骤，光标移动、滚动条更新、重绘和
+ * > EVT\_VALUE\_CHANGED事件都推迟到批量修改结束时做一次(EVT\_CODE\_EDIT\_TEXT\_CHANGED事件照常触发)。
+ * > 可以嵌套调用，与code\_edit\_end\_batch必须成对使用。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_begin_batch(widget_t* widget);
+
+/**
+ * @method code_edit_end_batch
+ * 结束批量修改。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_end_batch(widget_t* widget);
+
+/**
+ * @method code_edit_get_text_range
+ * 获取指定范围的文本。
+ *
+ * > 只复制指定范围的文本，适合在很大的文档中读取局部内容。超出文档的部分会被截掉。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {uint32_t} start 起始偏移位置。
+ * @param {uint32_t} end 结束偏移位置(不包括)。
+ * @param {str_t*} text 用于返回文本。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_get_text_range(widget_t* widget, uint32_t start, uint32_t end, str_t* text);
+
+/**
+ * @method code_edit_get_line
+ * 获取指定行的文本(不包括换行符)。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {uint32_t} line 行号(从0开始)。
+ * @param {str_t*} text 用于返回文本。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_get_line(widget_t* widget, uint32_t line, str_t* text);
+
+/**
+ * @method code_edit_get_line_count
+ * 获取行数。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ *
+ * @return {uint32_t} 返回行数(空文档也有一行)。
+ */
+uint32_t code_edit_get_line_count(widget_t* widget);
+
+/**
+ * @method code_edit_line_from_offset
+ * 获取偏移位置所在的行号。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {uint32_t} offset 偏移位置(超出文档时返回最后一行)。
+ *
+ * @return {uint32_t} 返回行号(从0开始)。
+ */
+uint32_t code_edit_line_from_offset(widget_t* widget, uint32_t offset);
+
+/**
+ * @method code_edit_offset_from_line
+ * 获取指定行开始的偏移位置。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {uint32_t} line 行号(从0开始)。
+ *
+ * @return {int32_t} 返回偏移位置(行号等于行数时返回文档长度，大于行数时返回-1)。
+ */
+int32_t code_edit_offset_from_line(widget_t* widget, uint32_t line);
+
 /**
  * @method code_edit_redo
  * 重做。
@@ -420,6 +656,57 @@ ret_t code_edit_save(widget_t* widget, const char* filename, bool_t with_utf8_bo
  */
 ret_t code_edit_load(widget_t* widget, const char* filename);
 
+/**
+ * @method code_edit_load_async
+ * 在后台线程中加载文件，加载期间UI线程不会被阻塞。
+ *
+ * > 加载过程中触发EVT\_PROGRESS事件，加载完成并替换文档后触发EVT\_DONE事件，失败时触发EVT\_ERROR事件。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {const char*} filename 文件名(为NULL时使用filename属性)。
+ *
+ * @return {ret_t} 返回RET_OK表示开始加载，否则表示失败。
+ */
+ret_t code_edit_load_async(widget_t* widget, const char* filename);
+
+/**
+ * @method code_edit_load_mapped
+ * 以只读方式把文件映射到内存中查看，适合查看很大的日志文件。
+ *
+ * > 文本不复制到文档缓冲区，只有访问到的页面才会占用内存。文档立即显示，行索引在UI线程的空闲处理中分步建立，
+ * > 已经索引的行随之追加到文档末尾，事件与code\_edit\_load\_async相同。映射的文档始终只读，且不做语法高亮，
+ * > 设置新的文本或加载其它文件后解除映射，恢复原来的readonly设置。
+ * >
+ * > 映射期间文件不能被其它进程截断，否则访问超出文件末尾的部分时进程会收到SIGBUS信号。
+ * > 建立索引期间发现文件变短时解除映射并触发EVT\_ERROR，但索引完成后的截断无法检测，只适合查看不再写入的文件(如已经轮转的日志)。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ * @param {const char*} filename 文件名(为NULL时使用filename属性)。
+ *
+ * @return {ret_t} 返回RET_OK表示开始加载，否则表示失败。
+ */
+ret_t code_edit_load_mapped(widget_t* widget, const char* filename);
+
+/**
+ * @method code_edit_cancel_load
+ * 取消后台加载文件，当前文档保持不变。映射文件时停止建立索引，只显示已经索引的部分。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t code_edit_cancel_load(widget_t* widget);
+
+/**
+ * @method code_edit_is_loading
+ * 检查是否正在后台加载文件。
+ * @annotation ["scriptable"]
+ * @param {widget_t*} widget widget对象。
+ *
+ * @return {bool_t} 返回TRUE表示正在加载，否则表示没有。
+ */
+bool_t code_edit_is_loading(widget_t* widget);
+
 /**
  * @method code_edit_is_modified
  * 检查文档是否变化。
@@ -438,6 +725,99 @@ bool_t code_edit_is_modified(widget_t* widget);
 #define CODE_EDIT_PROP_ZOOM "zoom"
 #define CODE_EDIT_PROP_WRAP_WORD "wrap_word"
 #define CODE_EDIT_PROP_SCROLL_LINE "scroll_line"
+#define CODE_EDIT_PROP_ATOMIC_SAVE "atomic_save"
+#define CODE_EDIT_PROP_KEEP_BACKUP "keep_backup"
+#define CODE_EDIT_PROP_BACKGROUND_LEXING "background_lexing"
+#define CODE_EDIT_PROP_IDLE_STYLING "idle_styling"
+#define CODE_EDIT_PROP_STYLING_BUDGET_US "styling_budget_us"
+#define CODE_EDIT_PROP_LEX_THREADS "lex_threads"
+
+/*只读属性：窗口管理器绘制时编辑器没有脏区、跳过重绘的帧数(用于性能分析)。*/
+#define CODE_EDIT_PROP_SKIPPED_FRAMES "skipped_frames"
+
+/*只读属性：编辑器累计请求重绘的次数，批量修改期间的请求合并为一次(用于性能分析)。*/
+#define CODE_EDIT_PROP_REDRAW_REQUESTS "redraw_requests"
+
+/*只读属性：最近一帧排版的行数(用于性能分析)。*/
+#define CODE_EDIT_PROP_PAINTED_LINES "painted_lines"
+
+/*只读属性：最近一帧切换字体的次数(用于性能分析)。*/
+#define CODE_EDIT_PROP_FONT_SWITCHES "font_switches"
+
+/*只读属性：字体缓存命中的次数，所有编辑器共享同一个字体缓存(用于性能分析)。*/
+#define CODE_EDIT_PROP_FONT_CACHE_HITS "font_cache_hits"
+
+/*只读属性：字体缓存未命中的次数，即实际创建字体的次数(用于性能分析)。*/
+#define CODE_EDIT_PROP_FONT_CACHE_MISSES "font_cache_misses"
+
+/*只读属性：最近一帧请求填充矩形的次数(用于性能分析)。*/
+#define CODE_EDIT_PROP_FILL_REQUESTS "fill_requests"
+
+/*只读属性：最近一帧合并相邻填充后实际提交给canvas的填充次数(用于性能分析)。*/
+#define CODE_EDIT_PROP_FILL_RECTS "fill_rects"
+
+/*只读属性：最近一帧因文字背景与已绘制背景相同而省略的填充次数(用于性能分析)。*/
+#define CODE_EDIT_PROP_FILLS_ELIDED "fills_elided"
+
+/*只读属性：最近一次后台词法分析保留了并行分析结果的块数，之后的部分顺序分析，0表示全部顺序分析(用于性能分析)。*/
+#define CODE_EDIT_PROP_LEX_CHUNKS "lex_chunks"
+
+/**
+ * code_edit保留的事件类型范围：[EVT_CODE_EDIT_START, EVT_CODE_EDIT_START + 0xff]。
+ *
+ * > 应用程序自定义的事件(通常从EVT_USER_START开始编号)请不要使用这个范围。
+ */
+#define EVT_CODE_EDIT_START (EVT_USER_START + 0x7f00)
+
+/*文本增量变化事件(code_edit_text_changed_event_t)。*/
+#define EVT_CODE_EDIT_TEXT_CHANGED (EVT_CODE_EDIT_START + 1)
+
+/**
+ * 文本增量变化事件。
+ *
+ * > 每次插入或删除文本(包括撤销和重做)触发一次，监听者可以据此增量更新自己的副本，
+ * > 不需要通过WIDGET\_PROP\_TEXT属性复制整个文档。替换整个文档(如加载文件)时，
+ * > deleted\_length和inserted\_length均为-1，inserted为NULL，监听者需要重新获取全部文本。
+ */
+typedef struct _code_edit_text_changed_event_t {
+  event_t e;
+
+  /*变化的位置(字节偏移)。*/
+  int32_t offset;
+  /*删除的字节数。*/
+  int32_t deleted_length;
+  /*插入的字节数。*/
+  int32_t inserted_length;
+  /*插入的文本(不以\0结束，只在事件处理期间有效)。*/
+  const char* inserted;
+} code_edit_text_changed_event_t;
+
+/*样式分析耗时事件(code_edit_styling_event_t)。*/
+#define EVT_CODE_EDIT_STYLING (EVT_CODE_EDIT_START + 2)
+
+/**
+ * 样式分析耗时事件。
+ *
+ * > 一帧的绘制或一次空闲处理中做了样式分析时触发一次，用于按实际设备调整idle\_styling和
+ * > styling\_budget\_us。
+ */
+typedef struct _code_edit_styling_event_t {
+  event_t e;
+
+  /*本次样式分析的耗时(微秒)。*/
+  uint32_t duration_us;
+  /*本次分析的行数。*/
+  uint32_t lines;
+  /*已分析到的位置(字节偏移)。*/
+  int32_t end_styled;
+  /*文档的长度(字节数)。*/
+  int32_t length;
+  /*是否在空闲时分析(否则在绘制时分析)。*/
+  bool_t idle;
+} code_edit_styling_event_t;
+
+/*只读属性：文档的版本号，每次插入、删除或替换文档后递增。*/
+#define CODE_EDIT_PROP_GENERATION "generation"
 
 #define WIDGET_TYPE_CODE_EDIT "code_edit"
 
@@ -454,6 +834,9 @@ ret_t code_edit_on_add_child(widget_t* widget, widget_t* child);
 ret_t code_edit_get_prop(widget_t* widget, const char* name, value_t* v);
 ret_t code_edit_set_prop(widget_t* widget, const char* name, const value_t* v);
 
+/*public for test*/
+ret_t code_edit_get_dirty_rect(widget_t* widget, rect_t* r, bool_t reset);
+
 END_C_DECLS
 
 #endif /*TK_CODE_EDIT_H*/
@@ -7,6 +7,12 @@ const char* s_code_edit_properties[] = {CODE_EDIT_PROP_LANG,
                                         CODE_EDIT_PROP_ZOOM,
                                         CODE_EDIT_PROP_WRAP_WORD,
                                         CODE_EDIT_PROP_SCROLL_LINE,
+                                        CODE_EDIT_PROP_ATOMIC_SAVE,
+                                        CODE_EDIT_PROP_KEEP_BACKUP,
+                                        CODE_EDIT_PROP_BACKGROUND_LEXING,
+                                        CODE_EDIT_PROP_IDLE_STYLING,
+                                        CODE_EDIT_PROP_STYLING_BUDGET_US,
+                                        CODE_EDIT_PROP_LEX_THREADS,
                                         NULL};
 
 TK_DECL_VTABLE(code_edit) = {.size = sizeof(code_edit_t),
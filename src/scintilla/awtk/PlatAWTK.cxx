@@ -12,9 +12,11 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <list>
 #include <algorithm>
 #include <memory>
 #include <sstream>
+#include <unordered_map>
 
 #include "awtk.h"
 #include "Platform.h"
@@ -27,6 +29,7 @@
 #include "UniConversion.h"
 
 #include "Converter.h"
+#include "PlatAWTK.h"
 
 #ifdef _MSC_VER
 // Ignore unreferenced local functions in AWTK headers
@@ -41,26 +44,40 @@ static color_t color_from_sci(ColourDesired from) {
 
 namespace {
 
-// Holds a PangoFontDescription*.
+/*FontHandle由FontCache统一管理，相同参数的字体在所有样式和所有编辑器实例之间共享。*/
 class FontHandle {
  public:
-  char* name;
+  /*由FontCache分配且不会重复使用，字体释放后新字体的地址可能与之相同，比较时使用id。*/
+  uint32_t id;
+  std::string family;
+  std::string name;
   uint32_t size;
   uint32_t weight;
   bool_t italic;
+  uint32_t refs;
+
+  /*字体度量，第一次绑定到canvas时查询。*/
+  bool metricsValid;
+  float_t ascent;
+  float_t descent;
+  float_t line_height;
+
+  /*字宽缓存，与字体和字号一一对应，字体改变时随FontHandle一起重建。*/
+  float_t latin1[256];
+  std::unordered_map<uint32_t, float_t> advances;
 
  public:
-  FontHandle() noexcept {
-    this->name = NULL;
-    this->weight = 400;
-    this->italic = false;
-    this->size = TK_DEFAULT_FONT_SIZE;
-  }
-  FontHandle(const FontParameters& fp) noexcept {
-    this->name = NULL;
-    this->weight = fp.weight;
-    this->italic = fp.italic;
-    this->size = fp.size;
+  FontHandle(uint32_t id_, const char* family_, const char* name_, uint32_t size_,
+             uint32_t weight_, bool_t italic_) {
+    this->id = id_;
+    this->family = family_ != NULL ? family_ : "";
+    this->name = name_ != NULL ? name_ : "";
+    this->size = size_;
+    this->weight = weight_;
+    this->italic = italic_;
+    this->refs = 0;
+    this->ResetMetrics();
+    this->ResetAdvances();
   }
   // Deleted so FontHandle objects can not be copied.
   FontHandle(const FontHandle&) = delete;
@@ -68,13 +85,192 @@ class FontHandle {
   FontHandle& operator=(const FontHandle&) = delete;
   FontHandle& operator=(FontHandle&&) = delete;
   ~FontHandle() {
-    TKMEM_FREE(this->name);
   }
-  static FontHandle* CreateNewFont(const FontParameters& fp);
+
+  /*缺省字体使用NULL，由AWTK选择系统字体。*/
+  const char* FontName() const noexcept {
+    return this->name.empty() ? NULL : this->name.c_str();
+  }
+
+  void ResetMetrics() noexcept {
+    this->metricsValid = false;
+    this->ascent = 15;
+    this->descent = 5;
+    this->line_height = 20;
+  }
+
+  void ResetAdvances() noexcept {
+    /*小于0表示尚未测量。*/
+    for (size_t i = 0; i < ARRAY_SIZE(this->latin1); i++) {
+      this->latin1[i] = -1;
+    }
+    this->advances.clear();
+  }
+
+  bool GetAdvance(uint32_t c, float_t* advance) const {
+    if (c < ARRAY_SIZE(this->latin1)) {
+      *advance = this->latin1[c];
+      return *advance >= 0;
+    } else {
+      std::unordered_map<uint32_t, float_t>::const_iterator it = this->advances.find(c);
+      if (it != this->advances.end()) {
+        *advance = it->second;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void SetAdvance(uint32_t c, float_t advance) {
+    if (c < ARRAY_SIZE(this->latin1)) {
+      this->latin1[c] = advance;
+    } else {
+      this->advances[c] = advance;
+    }
+  }
+
+};
+
+/*按字体名称、字号、粗细和是否斜体缓存字体。*/
+class FontCache {
+  struct Key {
+    std::string family;
+    /*FontParameters中的字号可能带小数，保留原值，避免不同的字号共用同一个字体。*/
+    float size;
+    uint32_t weight;
+    bool italic;
+
+    bool operator<(const Key& other) const {
+      if (this->size != other.size) {
+        return this->size < other.size;
+      } else if (this->weight != other.weight) {
+        return this->weight < other.weight;
+      } else if (this->italic != other.italic) {
+        return this->italic < other.italic;
+      }
+      return this->family < other.family;
+    }
+  };
+
+  /*没有引用的字体最多保留的个数，样式刷新时会先释放再重新创建全部字体，保留它们可以复用字宽缓存。*/
+  enum { maxUnused = 64 };
+
+  std::map<Key, std::unique_ptr<FontHandle>> fonts;
+  /*没有引用的字体，最近释放的在前面，超过maxUnused时删除最久没有使用的。*/
+  std::list<FontHandle*> unused;
+  uint32_t nextId;
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t lookups;
+
+ public:
+  FontCache() noexcept : nextId(0), hits(0), misses(0), lookups(0) {
+  }
+
+  FontHandle* Acquire(const FontParameters& fp) {
+    Key key;
+    FontHandle* fh = NULL;
+
+    key.family = fp.faceName != NULL ? fp.faceName : "";
+    key.size = fp.size;
+    key.weight = fp.weight;
+    key.italic = fp.italic;
+
+    std::map<Key, std::unique_ptr<FontHandle>>::iterator it = this->fonts.find(key);
+    if (it != this->fonts.end()) {
+      this->hits++;
+      fh = it->second.get();
+      if (fh->refs == 0) {
+        this->unused.remove(fh);
+      }
+    } else {
+      this->misses++;
+      /*0表示没有绑定字体。*/
+      if (++this->nextId == 0) {
+        this->nextId++;
+      }
+      std::string name = this->ResolveName(key.family.c_str(), static_cast<uint32_t>(key.size),
+                                           key.weight >= SC_WEIGHT_BOLD, key.italic);
+      fh = new FontHandle(this->nextId, key.family.c_str(), name.c_str(),
+                          static_cast<uint32_t>(key.size), key.weight, key.italic);
+      this->fonts[key] = std::unique_ptr<FontHandle>(fh);
+    }
+    fh->refs++;
+
+    return fh;
+  }
+
+  void Release(FontHandle* fh) {
+    return_if_fail(fh != NULL && fh->refs > 0);
+
+    fh->refs--;
+    if (fh->refs == 0) {
+      this->unused.push_front(fh);
+      if (this->unused.size() > static_cast<size_t>(maxUnused)) {
+        this->Remove(this->unused.back());
+        this->unused.pop_back();
+      }
+    }
+  }
+
+  void GetStats(FontCacheStats* stats) const {
+    stats->hits = this->hits;
+    stats->misses = this->misses;
+    stats->lookups = this->lookups;
+    stats->fonts = this->fonts.size();
+  }
+
+ private:
+  /*
+   * AWTK中没有在绘制时加粗/倾斜的接口，粗体和斜体通过名为family_bold、family_italic、
+   * family_bold_italic的字体资源提供，找不到时依次使用常规字体family和缺省字体(空字符串)。
+   * 只在创建FontHandle时查找一次，结果(包括找不到的情况)保存在FontHandle中，之后设置字体时
+   * 不会再去加载不存在的字体资源。
+   */
+  std::string ResolveName(const char* family, uint32_t size, bool bold, bool italic) {
+    const char* suffix = bold ? (italic ? "_bold_italic" : "_bold") : (italic ? "_italic" : "");
+
+    if (*suffix != '\0') {
+      std::string name = std::string(*family != '\0' ? family : "default") + suffix;
+      if (this->Exists(name.c_str(), size)) {
+        return name;
+      }
+    }
+
+    if (*family != '\0' && this->Exists(family, size)) {
+      return family;
+    }
+
+    return "";
+  }
+
+  /*font_manager_get_font找不到时可能返回缺省字体，通过名称判断是否是要找的字体。*/
+  bool Exists(const char* name, uint32_t size) {
+    font_t* font = NULL;
+
+    this->lookups++;
+    font = font_manager_get_font(font_manager(), name, size);
+
+    return font != NULL && tk_str_eq(font->name, name);
+  }
+
+  void Remove(FontHandle* fh) {
+    std::map<Key, std::unique_ptr<FontHandle>>::iterator it = this->fonts.begin();
+
+    for (; it != this->fonts.end(); ++it) {
+      if (it->second.get() == fh) {
+        this->fonts.erase(it);
+        break;
+      }
+    }
+  }
 };
 
-FontHandle* FontHandle::CreateNewFont(const FontParameters& fp) {
-  return new FontHandle(fp);
+FontCache& SharedFontCache() {
+  static FontCache cache;
+
+  return cache;
 }
 
 // X has a 16 bit coordinate space, so stop drawing here to avoid wrapping
@@ -90,11 +286,11 @@ Font::~Font() {
 
 void Font::Create(const FontParameters& fp) {
   Release();
-  fid = FontHandle::CreateNewFont(fp);
+  fid = SharedFontCache().Acquire(fp);
 }
 
 void Font::Release() {
-  if (fid) delete static_cast<FontHandle*>(fid);
+  if (fid) SharedFontCache().Release(static_cast<FontHandle*>(fid));
   fid = nullptr;
 }
 
@@ -107,9 +303,25 @@ class SurfaceImpl : public Surface {
   int y;
   bool inited;
   bool createdGC;
-  float ascent;
-  float descent;
-  float line_height;
+  /*当前绑定到canvas的字体的FontHandle::id，0表示没有。*/
+  uint32_t fontId;
+  uint32_t fontSwitches;
+  /*相邻的同色填充合并后再提交给canvas，其它绘制操作之前需要先提交。*/
+  bool hasFill;
+  rect_t fill;
+  color_t fillColor;
+  bool hasClip;
+  rect_t clip;
+  /*
+   * 当前行带(y和高度相同)中已经填充且还没有被覆盖的区域和颜色，文字背景与之相同且在其中时不再
+   * 重复填充。同一行带上相连的同色填充合并到一起，绘制文字时只去掉文字覆盖的部分。
+   */
+  bool hasBack;
+  rect_t back;
+  color_t backColor;
+  uint32_t fillRequests;
+  uint32_t fills;
+  uint32_t fillsElided;
   Converter conv;
   int characterSet;
   canvas_t* canvas;
@@ -120,7 +332,15 @@ class SurfaceImpl : public Surface {
   wstr_t wstr;
   void SetConverter(int characterSet_);
 
-  void SetFont(Font& font);
+  void SetFont(Font& font_);
+  bool ToFillRect(PRectangle rc, rect_t* r) const;
+  void FillTextBack(PRectangle rc, ColourDesired back);
+  void ForgetBack(PRectangle rc);
+  void FlushFill();
+  void ResetClip();
+  void BeginVgDraw();
+  const FontHandle* Metrics(Font& font_);
+  float_t CharAdvance(Font& font_, uint32_t c);
   vgcanvas_t* GetVgCanvas();
 
  public:
@@ -179,6 +399,8 @@ class SurfaceImpl : public Surface {
 
   void SetUnicodeMode(bool unicodeMode_) override;
   void SetDBCSMode(int codePage) override;
+
+  void GetStats(SurfaceStats* stats) const;
 };
 }  // namespace Scintilla
 
@@ -246,9 +468,19 @@ SurfaceImpl::SurfaceImpl() noexcept
   this->vg = NULL;
   this->canvas = NULL;
   this->widget = NULL;
-  this->ascent = 15;
-  this->descent = 5;
-  this->line_height = 20;
+  this->fontId = 0;
+  this->fontSwitches = 0;
+  this->hasFill = false;
+  this->fill = rect_init(0, 0, 0, 0);
+  this->fillColor = color_init(0, 0, 0, 0);
+  this->hasClip = false;
+  this->clip = rect_init(0, 0, 0, 0);
+  this->hasBack = false;
+  this->back = rect_init(0, 0, 0, 0);
+  this->backColor = color_init(0, 0, 0, 0);
+  this->fillRequests = 0;
+  this->fills = 0;
+  this->fillsElided = 0;
   this->pen_color = color_init(0, 0, 0, 0);
 
   str_init(&(this->str), 256);
@@ -268,9 +500,16 @@ void SurfaceImpl::Clear() noexcept {
   inited = false;
   createdGC = false;
   characterSet = -1;
+  /*canvas的字体可能在两帧之间被其它控件修改，重新绑定时需要重新设置。*/
+  fontId = 0;
+  hasFill = false;
+  hasClip = false;
+  hasBack = false;
 }
 
 void SurfaceImpl::Release() {
+  FlushFill();
+  ResetClip();
   Clear();
 }
 
@@ -327,6 +566,7 @@ void SurfaceImpl::MoveTo(int x, int y) {
   this->y = y;
   vgcanvas_t* vg = this->GetVgCanvas();
   return_if_fail(vg != NULL);
+  this->BeginVgDraw();
   int ox = this->canvas->ox;
   int oy = this->canvas->oy;
 
@@ -338,6 +578,7 @@ void SurfaceImpl::LineTo(int x, int y) {
   this->y = y;
   vgcanvas_t* vg = this->GetVgCanvas();
   return_if_fail(vg != NULL);
+  this->BeginVgDraw();
 
   int ox = this->canvas->ox;
   int oy = this->canvas->oy;
@@ -347,6 +588,7 @@ void SurfaceImpl::LineTo(int x, int y) {
 void SurfaceImpl::Polygon(Point* pts, size_t npts, ColourDesired fore, ColourDesired back) {
   vgcanvas_t* vg = this->GetVgCanvas();
   return_if_fail(vg != NULL);
+  this->BeginVgDraw();
 
   vgcanvas_begin_path(vg);
   vgcanvas_move_to(vg, pts[0].x + 0.5, pts[0].y + 0.5);
@@ -367,6 +609,7 @@ void SurfaceImpl::RectangleDraw(PRectangle rc, ColourDesired fore, ColourDesired
   vgcanvas_t* vg = this->GetVgCanvas();
 
   return_if_fail(vg != NULL);
+  this->BeginVgDraw();
   if (rc.left > rc.right || rc.top > rc.bottom) {
     return;
   }
@@ -384,27 +627,107 @@ void SurfaceImpl::RectangleDraw(PRectangle rc, ColourDesired fore, ColourDesired
   vgcanvas_stroke(vg);
 }
 
+bool SurfaceImpl::ToFillRect(PRectangle rc, rect_t* r) const {
+  if (rc.left > rc.right || rc.top > rc.bottom) {
+    return false;
+  }
+
+  /*与原来vgcanvas_rect的填充大小相同，包含右边和下边的一个像素。*/
+  r->x = std::round(rc.left);
+  r->y = std::round(rc.top);
+  r->w = std::round(rc.right) - r->x + 1;
+  r->h = std::round(rc.bottom) - r->y + 1;
+  if (this->hasClip) {
+    *r = rect_intersect(r, &(this->clip));
+  }
+
+  return r->w > 0 && r->h > 0;
+}
+
 void SurfaceImpl::FillRectangle(PRectangle rc, ColourDesired back) {
-  int w = rc.right - rc.left + 1;
-  int h = rc.bottom - rc.top + 1;
-  vgcanvas_t* vg = this->GetVgCanvas();
-  return_if_fail(vg != NULL);
+  rect_t r;
+  color_t color = color_from_sci(back);
+  return_if_fail(this->canvas != NULL);
 
-  if (rc.left > rc.right || rc.top > rc.bottom) {
+  /*轴对齐的填充直接使用canvas_fill_rect，不经过vgcanvas的路径填充。*/
+  if (!this->ToFillRect(rc, &r)) {
     return;
   }
 
-  rc.left = std::round(rc.left);
-  rc.right = std::round(rc.right);
+  /*每次填充都多出一个像素，相邻的两块重叠一列。*/
+  this->fillRequests++;
+  if (this->hasFill && this->fillColor.color == color.color && this->fill.y == r.y &&
+      this->fill.h == r.h && r.x >= this->fill.x && r.x <= this->fill.x + this->fill.w) {
+    this->fill.w = tk_max(this->fill.x + this->fill.w, r.x + r.w) - this->fill.x;
+  } else {
+    this->FlushFill();
+    this->hasFill = true;
+    this->fill = r;
+    this->fillColor = color;
+  }
 
-  int ox = this->canvas->ox;
-  int oy = this->canvas->oy;
-  vgcanvas_translate(vg, ox, oy);
-  vgcanvas_rect(vg, rc.left, rc.top, w, h);
-  vgcanvas_translate(vg, -ox, -oy);
+  if (this->hasBack && this->backColor.color == color.color && this->back.y == r.y &&
+      this->back.h == r.h && r.x <= this->back.x + this->back.w && r.x + r.w >= this->back.x) {
+    xy_t right = tk_max(this->back.x + this->back.w, r.x + r.w);
+    this->back.x = tk_min(this->back.x, r.x);
+    this->back.w = right - this->back.x;
+  } else {
+    this->hasBack = true;
+    this->back = r;
+    this->backColor = color;
+  }
+}
 
-  vgcanvas_set_fill_color(vg, color_from_sci(back));
-  vgcanvas_fill(vg);
+void SurfaceImpl::FillTextBack(PRectangle rc, ColourDesired back) {
+  rect_t r;
+  color_t color = color_from_sci(back);
+
+  /*文字的背景已经由行背景或边栏背景画好时，不再重复填充。*/
+  if (this->hasBack && this->backColor.color == color.color && this->ToFillRect(rc, &r)) {
+    if (r.x >= this->back.x && r.y >= this->back.y &&
+        r.x + r.w <= this->back.x + this->back.w && r.y + r.h <= this->back.y + this->back.h) {
+      this->fillsElided++;
+      return;
+    }
+  }
+
+  this->FillRectangle(rc, back);
+}
+
+void SurfaceImpl::ForgetBack(PRectangle rc) {
+  /*文字画在[left, right)之内，不像填充那样多出一个像素。*/
+  const xy_t left = std::round(rc.left);
+  const xy_t right = std::round(rc.right);
+  const xy_t top = std::round(rc.top);
+  const xy_t bottom = std::round(rc.bottom);
+
+  if (!this->hasBack || right <= this->back.x || left >= this->back.x + this->back.w ||
+      bottom <= this->back.y || top >= this->back.y + this->back.h) {
+    return;
+  }
+
+  /*文字从左向右绘制，只保留被覆盖部分右边的区域，后面的文字还可以省略背景填充。*/
+  if (right >= this->back.x + this->back.w) {
+    this->hasBack = false;
+  } else {
+    this->back.w = this->back.x + this->back.w - right;
+    this->back.x = right;
+  }
+}
+
+void SurfaceImpl::FlushFill() {
+  if (this->hasFill) {
+    this->hasFill = false;
+    this->fills++;
+    canvas_set_fill_color(this->canvas, this->fillColor);
+    canvas_fill_rect(this->canvas, this->fill.x, this->fill.y, this->fill.w, this->fill.h);
+  }
+}
+
+void SurfaceImpl::BeginVgDraw() {
+  /*vgcanvas绘制的内容可能覆盖最近一次填充的区域。*/
+  this->FlushFill();
+  this->hasBack = false;
 }
 
 void SurfaceImpl::FillRectangle(PRectangle rc, Surface& surfacePattern) {
@@ -414,6 +737,7 @@ void SurfaceImpl::FillRectangle(PRectangle rc, Surface& surfacePattern) {
 void SurfaceImpl::RoundedRectangle(PRectangle rc, ColourDesired fore, ColourDesired back) {
   vgcanvas_t* vg = this->GetVgCanvas();
   return_if_fail(vg != NULL);
+  this->BeginVgDraw();
 
   vgcanvas_begin_path(vg);
   int ox = this->canvas->ox;
@@ -452,6 +776,7 @@ void SurfaceImpl::Ellipse(PRectangle rc, ColourDesired fore, ColourDesired back)
   float_t ry = (rc.bottom - rc.top) / 2;
 
   return_if_fail(vg != NULL);
+  this->BeginVgDraw();
 
   vgcanvas_begin_path(vg);
   int ox = this->canvas->ox;
@@ -469,54 +794,85 @@ void SurfaceImpl::Ellipse(PRectangle rc, ColourDesired fore, ColourDesired back)
 void SurfaceImpl::Copy(PRectangle rc, Point from, Surface& surfaceSource) {
 }
 
-void SurfaceImpl::SetFont(Font& font) {
-  vgcanvas_t* vg = this->GetVgCanvas();
-  FontHandle* fh = static_cast<FontHandle*>(font.fid);
+void SurfaceImpl::SetFont(Font& font_) {
+  vgcanvas_t* vg = NULL;
+  FontHandle* fh = static_cast<FontHandle*>(font_.fid);
+  return_if_fail(fh != NULL && this->canvas != NULL);
+
+  /*与当前绑定的字体相同时不再重复设置。*/
+  if (this->fontId == fh->id) {
+    return;
+  }
 
+  this->fontId = fh->id;
+  this->fontSwitches++;
+
+  vg = this->GetVgCanvas();
   if (vg != NULL) {
+    vgcanvas_set_font(vg, fh->FontName());
+    vgcanvas_set_font_size(vg, fh->size);
+  }
+  canvas_set_font(this->canvas, fh->FontName(), fh->size);
+
+  if (!fh->metricsValid) {
     float_t a = 0;
     float_t d = 0;
     float_t lh = 0;
-    vgcanvas_set_font(vg, NULL);
-    vgcanvas_set_font_size(vg, fh->size);
-    canvas_set_font(this->canvas, NULL, fh->size);
 
     canvas_get_text_metrics(this->canvas, &a, &d, &lh);
-    this->ascent = tk_abs(a);
-    this->descent = tk_abs(d);
-    this->line_height = lh;
+    fh->ascent = tk_abs(a);
+    fh->descent = tk_abs(d);
+    fh->line_height = lh;
+    fh->metricsValid = true;
   }
 
   return;
 }
 
+const FontHandle* SurfaceImpl::Metrics(Font& font_) {
+  const FontHandle* fh = static_cast<FontHandle*>(font_.fid);
+
+  if (!fh->metricsValid) {
+    this->SetFont(font_);
+  }
+
+  return fh;
+}
+
 void SurfaceImpl::DrawTextBase(PRectangle rc, Font& font_, XYPOSITION ybase, const char* s,
                                int len, ColourDesired fore) {
   vgcanvas_t* vg = this->GetVgCanvas();
   str_t* str = &(this->str);
   return_if_fail(vg != NULL);
 
+  this->FlushFill();
   this->SetFont(font_);
   canvas_set_text_color(this->canvas, color_from_sci(fore));
   str_set_with_len(str, s, len);
   canvas_draw_utf8(this->canvas, str->str, rc.left, rc.top);
+
+  /*文字覆盖了这一部分背景，在同一区域再绘制文字时需要重新填充背景。*/
+  this->ForgetBack(rc);
 }
 
 void SurfaceImpl::DrawTextNoClip(PRectangle rc, Font& font_, XYPOSITION ybase, const char* s,
                                  int len, ColourDesired fore, ColourDesired back) {
-  FillRectangle(rc, back);
+  FillTextBack(rc, back);
   DrawTextBase(rc, font_, ybase, s, len, fore);
 }
 
 // On AWTK, exactly same as DrawTextNoClip
 void SurfaceImpl::DrawTextClipped(PRectangle rc, Font& font_, XYPOSITION ybase, const char* s,
                                   int len, ColourDesired fore, ColourDesired back) {
-  FillRectangle(rc, back);
+  FillTextBack(rc, back);
   DrawTextBase(rc, font_, ybase, s, len, fore);
 }
 
 void SurfaceImpl::DrawTextTransparent(PRectangle rc, Font& font_, XYPOSITION ybase, const char* s,
                                       int len, ColourDesired fore) {
+  /*透明文字画在已有的内容上，之后不能再认为该区域只有记录的背景。*/
+  this->ForgetBack(rc);
+
   // Avoid drawing spaces in transparent mode
   for (int i = 0; i < len; i++) {
     if (s[i] != ' ') {
@@ -526,51 +882,90 @@ void SurfaceImpl::DrawTextTransparent(PRectangle rc, Font& font_, XYPOSITION yba
   }
 }
 
+/*解码一个UTF-8字符，返回其字节数，无效字节按Latin-1单字节处理。*/
+static int DecodeChar(const unsigned char* us, int len, uint32_t* c) {
+  int n = 1;
+
+  *c = us[0];
+  if (*c >= 0x80) {
+    const int cls = UTF8Classify(us, len);
+    if (!(cls & UTF8MaskInvalid)) {
+      n = cls & UTF8MaskWidth;
+      *c = UnicodeFromUTF8(us);
+    }
+  }
+
+  return n;
+}
+
+float_t SurfaceImpl::CharAdvance(Font& font_, uint32_t c) {
+  float_t advance = 0;
+  FontHandle* fh = static_cast<FontHandle*>(font_.fid);
+
+  if (fh->GetAdvance(c, &advance)) {
+    return advance;
+  }
+
+  /*未命中时才设置字体并测量，命中时不访问canvas。*/
+  this->SetFont(font_);
+
+  if (sizeof(wchar_t) == 2 && c >= SUPPLEMENTAL_PLANE_FIRST) {
+    wchar_t wc[2];
+    const uint32_t u = c - SUPPLEMENTAL_PLANE_FIRST;
+    wc[0] = static_cast<wchar_t>(SURROGATE_LEAD_FIRST + (u >> 10));
+    wc[1] = static_cast<wchar_t>(SURROGATE_TRAIL_FIRST + (u & 0x3ff));
+    advance = canvas_measure_text(this->canvas, wc, 2);
+  } else {
+    wchar_t wc = static_cast<wchar_t>(c);
+    advance = canvas_measure_text(this->canvas, &wc, 1);
+  }
+  fh->SetAdvance(c, advance);
+
+  return advance;
+}
+
 void SurfaceImpl::MeasureWidths(Font& font_, const char* s, int len, XYPOSITION* positions) {
-  uint32_t i = 0;
+  int i = 0;
   float_t x = 0;
-  uint32_t k = 0;
-  uint32_t j = 0;
-  str_t* str = &(this->str);
-  wstr_t* wstr = &(this->wstr);
-  vgcanvas_t* vg = this->GetVgCanvas();
-  return_if_fail(vg != NULL);
+  const unsigned char* us = reinterpret_cast<const unsigned char*>(s);
+  return_if_fail(this->canvas != NULL && font_.fid != NULL);
 
-  this->SetFont(font_);
-  str_set_with_len(str, s, len);
-  wstr_set_utf8(wstr, str->str);
-
-  for (i = 0; i < wstr->size; i++) {
-    wchar_t c = wstr->str[i];
-    str_from_wstr_with_len(str, &c, 1);
-    x += canvas_measure_text(this->canvas, &c, 1);
-    for (j = 0; j < str->size; j++) {
-      positions[k++] = tk_roundi(x);
-      assert(k <= len);
+  while (i < len) {
+    uint32_t c = 0;
+    const int n = DecodeChar(us + i, len - i, &c);
+
+    x += this->CharAdvance(font_, c);
+    for (int j = 0; j < n; j++) {
+      positions[i++] = tk_roundi(x);
     }
   }
 }
 
 XYPOSITION SurfaceImpl::WidthText(Font& font_, const char* s, int len) {
-  wstr_t* str = &(this->wstr);
-  wstr_set_utf8(str, s);
+  int i = 0;
+  float_t x = 0;
+  const unsigned char* us = reinterpret_cast<const unsigned char*>(s);
+  return_value_if_fail(this->canvas != NULL && font_.fid != NULL, 0);
 
-  this->SetFont(font_);
-  return canvas_measure_text(this->canvas, str->str, str->size);
+  while (i < len) {
+    uint32_t c = 0;
+    const int n = DecodeChar(us + i, len - i, &c);
+
+    x += this->CharAdvance(font_, c);
+    i += n;
+  }
+
+  return x;
 }
 
 // Ascent and descent determined by Pango font metrics.
 
 XYPOSITION SurfaceImpl::Ascent(Font& font_) {
-  this->SetFont(font_);
-
-  return this->ascent;
+  return this->Metrics(font_)->ascent;
 }
 
 XYPOSITION SurfaceImpl::Descent(Font& font_) {
-  this->SetFont(font_);
-
-  return this->descent;
+  return this->Metrics(font_)->descent;
 }
 
 XYPOSITION SurfaceImpl::InternalLeading(Font&) {
@@ -578,7 +973,8 @@ XYPOSITION SurfaceImpl::InternalLeading(Font&) {
 }
 
 XYPOSITION SurfaceImpl::Height(Font& font_) {
-  int h = this->line_height ? this->line_height : 20;
+  const FontHandle* fh = this->Metrics(font_);
+  int h = fh->line_height ? fh->line_height : 20;
 
   log_debug("h=%d\n", h);
 
@@ -593,6 +989,11 @@ void SurfaceImpl::SetClip(PRectangle rc) {
   vgcanvas_t* vg = this->GetVgCanvas();
   return_if_fail(vg != NULL);
 
+  /*canvas_fill_rect不受vgcanvas裁剪区影响，填充时自行裁剪。*/
+  this->FlushFill();
+  this->hasClip = true;
+  this->clip = rect_init(rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top);
+
   int x = this->canvas->ox + rc.left;
   int y = this->canvas->oy + rc.top;
   int w = rc.right - rc.left;
@@ -601,7 +1002,24 @@ void SurfaceImpl::SetClip(PRectangle rc) {
   vgcanvas_clip_rect(vg, x, y, w, h);
 }
 
+/*vgcanvas的裁剪区在控件之间共享，绘制结束时恢复为canvas的裁剪区，以免影响后面绘制的控件。*/
+void SurfaceImpl::ResetClip() {
+  rect_t r;
+  vgcanvas_t* vg = NULL;
+
+  if (!this->hasClip || this->canvas == NULL) {
+    return;
+  }
+
+  this->hasClip = false;
+  vg = this->GetVgCanvas();
+  if (vg != NULL && canvas_get_clip_rect(this->canvas, &r) == RET_OK) {
+    vgcanvas_clip_rect(vg, r.x, r.y, r.w, r.h);
+  }
+}
+
 void SurfaceImpl::FlushCachedState() {
+  this->FlushFill();
 }
 
 void SurfaceImpl::SetUnicodeMode(bool unicodeMode_) {
@@ -610,6 +1028,33 @@ void SurfaceImpl::SetUnicodeMode(bool unicodeMode_) {
 void SurfaceImpl::SetDBCSMode(int codePage) {
 }
 
+void SurfaceImpl::GetStats(SurfaceStats* stats) const {
+  stats->fontSwitches = this->fontSwitches;
+  stats->fillRequests = this->fillRequests;
+  stats->fills = this->fills;
+  stats->fillsElided = this->fillsElided;
+}
+
+void Scintilla::FontCacheGetStats(FontCacheStats* stats) {
+  return_if_fail(stats != NULL);
+
+  SharedFontCache().GetStats(stats);
+}
+
+const char* Scintilla::FontGetName(const Font& font) {
+  const FontHandle* fh = static_cast<const FontHandle*>(font.GetID());
+  return_value_if_fail(fh != NULL, NULL);
+
+  return fh->FontName();
+}
+
+void Scintilla::SurfaceGetStats(Surface* surface, SurfaceStats* stats) {
+  memset(stats, 0x00, sizeof(*stats));
+  return_if_fail(surface != NULL);
+
+  static_cast<SurfaceImpl*>(surface)->GetStats(stats);
+}
+
 Surface* Surface::Allocate(int) {
   return new SurfaceImpl();
 }
@@ -646,20 +1091,23 @@ PRectangle Window::GetClientPosition() const {
 }
 
 void Window::Show(bool show) {
-  widget_t* win = widget_get_window(WIDGET(this->wid));
-  widget_invalidate_force(win, NULL);
+  widget_invalidate(WIDGET(this->wid), NULL);
 }
 
+// Only mark the editor itself dirty, nothing is painted while it stays quiescent.
 void Window::InvalidateAll() {
-  widget_t* win = widget_get_window(WIDGET(this->wid));
-  widget_invalidate_force(win, NULL);
+  widget_invalidate_force(WIDGET(this->wid), NULL);
 }
 
+// rc is in client coordinates which are the same as the widget's local coordinates.
 void Window::InvalidateRectangle(PRectangle rc) {
-  widget_t* win = widget_get_window(WIDGET(this->wid));
-  rect_t r = rect_init(rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top);
+  xy_t left = std::floor(rc.left);
+  xy_t top = std::floor(rc.top);
+  rect_t r = rect_init(left, top, std::ceil(rc.right) - left, std::ceil(rc.bottom) - top);
 
-  widget_invalidate_force(win, &r);
+  if (r.w > 0 && r.h > 0) {
+    widget_invalidate_force(WIDGET(this->wid), &r);
+  }
 }
 
 void Window::SetFont(Font&) {
@@ -0,0 +1,43 @@
+// Scintilla source code edit control
+// PlatAWTK.h - AWTK specific extensions to the platform layer
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef PLATAWTK_H
+#define PLATAWTK_H
+
+#include <cstdint>
+
+namespace Scintilla {
+
+class Surface;
+class Font;
+
+/*Surface的绘制统计(用于性能分析)，计数从Surface创建开始累计。*/
+struct SurfaceStats {
+  uint32_t fontSwitches;
+  /*FillRectangle调用次数和合并后实际提交给canvas的填充次数。*/
+  uint32_t fillRequests;
+  uint32_t fills;
+  /*文字背景与已填充的背景相同而省略的填充次数。*/
+  uint32_t fillsElided;
+};
+
+void SurfaceGetStats(Surface* surface, SurfaceStats* stats);
+
+/*字体缓存的统计信息，所有编辑器实例共享同一个字体缓存。*/
+struct FontCacheStats {
+  uint32_t hits;
+  uint32_t misses;
+  /*查找字体资源是否存在的次数，每个字体创建时最多查找两次。*/
+  uint32_t lookups;
+  uint32_t fonts;
+};
+
+void FontCacheGetStats(FontCacheStats* stats);
+
+/*字体实际使用的字体资源名称，NULL表示缺省字体。*/
+const char* FontGetName(const Font& font);
+
+}  // namespace Scintilla
+
+#endif /*PLATAWTK_H*/
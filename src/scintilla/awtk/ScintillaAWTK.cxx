@@ -11,18 +11,23 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <atomic>
+#include <thread>
 #include <algorithm>
 #include <memory>
 
 #include "awtk.h"
+#include "tkc/mmap.h"
 #include "Platform.h"
 #include "ILoader.h"
 #include "ILexer.h"
 #include "Scintilla.h"
+#include "SciLexer.h"
 #include "ScintillaWidget.h"
 #include "StringCopy.h"
 #include "CharacterCategory.h"
 #include "LexerModule.h"
+#include "Catalogue.h"
 #include "Position.h"
 #include "UniqueString.h"
 #include "SplitVector.h"
@@ -65,18 +70,42 @@ ScintillaAWTK::ScintillaAWTK(WindowID wid) {
   this->widget = WIDGET(wid);
   this->bar_to_edit = FALSE;
   this->idle_id = TK_INVALID_ID;
+  this->repaint_idle_id = TK_INVALID_ID;
+  this->skipped_frames = 0;
+  this->redraw_requests = 0;
+  this->painted = false;
+  this->generation = 1;
+  this->batch_depth = 0;
+  this->batch_changed = false;
+  this->batch_redraw = false;
+  this->batch_scroll_bars = false;
+  this->batch_caret = INVALID_POSITION;
+  this->background_lexing = false;
+  this->lex_requested = false;
+  this->lex_idle_id = TK_INVALID_ID;
+  this->lex_job = NULL;
+  this->lex_threads = 0;
+  this->lex_chunks = 0;
+  memset(&(this->frame_stats), 0x00, sizeof(this->frame_stats));
+  this->damage = rect_init(0, 0, 0, 0);
+  this->invalidated = rect_init(0, 0, 0, 0);
   this->lastKeyDownConsumed = TRUE;
 
   memset(timers, 0x00, sizeof(timers));
 
   Scintilla_LinkLexers();
 
+  /*窗口管理器每绘制一帧检查一次编辑器是否重绘，统计跳过的帧数。*/
+  this->frame_id = widget_on(window_manager(), EVT_AFTER_PAINT, ScintillaAWTK::OnFramePainted, this);
+
   SSM(SCI_SETTABWIDTH, 4, 0);
   SSM(SCI_STYLECLEARALL, 0, 0);
   SSM(SCI_SETCODEPAGE, SC_CP_UTF8, 0);
   SSM(SCI_SETCARETPERIOD, 500, 0);
   SSM(SCI_SETFOCUS, 1, 0);
   SSM(SCI_SETZOOM, 0, 0);
+  /*缓存可见页的行布局，避免每帧重新分配LineLayout。*/
+  SSM(SCI_SETLAYOUTCACHE, SC_CACHE_PAGE, 0);
 #if 0
   SSM(SCI_SETLEXER, SCLEX_CPP, 0);
   SSM(SCI_STYLESETFORE, SCE_C_COMMENT, 0x008000);
@@ -103,6 +132,17 @@ ScintillaAWTK::~ScintillaAWTK() {
     FineTickerCancel(tr);
   }
   SetIdle(false);
+  CancelLexJob();
+
+  if (this->frame_id != TK_INVALID_ID) {
+    widget_off(window_manager(), this->frame_id);
+    this->frame_id = TK_INVALID_ID;
+  }
+
+  if (this->repaint_idle_id != TK_INVALID_ID) {
+    idle_remove(this->repaint_idle_id);
+    this->repaint_idle_id = TK_INVALID_ID;
+  }
 }
 
 void ScintillaAWTK::OnScrollBarChange(const char* name, int32_t value) {
@@ -144,8 +184,14 @@ void ScintillaAWTK::SetVerticalScrollPos() {
 bool ScintillaAWTK::ModifyScrollBars(Sci::Line nMax, Sci::Line nPage) {
   int line_height = this->vs.lineHeight;
   int virtual_height = nMax * line_height;
-  widget_t* bar = widget_lookup(this->widget, VBAR_NAME, TRUE);
+  widget_t* bar = NULL;
 
+  if (this->batch_depth > 0) {
+    this->batch_scroll_bars = true;
+    return false;
+  }
+
+  bar = widget_lookup(this->widget, VBAR_NAME, TRUE);
   if (bar != NULL) {
     scroll_bar_set_params(bar, virtual_height, line_height);
   }
@@ -190,18 +236,1501 @@ void ScintillaAWTK::SetMouseCapture(bool on) {
   }
 }
 
+/*替换为新建的文档。词法分析器的实例属于文档，在新文档上重新创建并设置原来的属性和关键字。*/
+void ScintillaAWTK::AttachDocument(void* doc) {
+  const sptr_t lexer = ScintillaBase::WndProc(SCI_GETLEXER, 0, 0);
+  const std::map<std::string, std::string> properties = this->lex_properties;
+  const std::vector<std::string> keywords = this->lex_keywords;
+
+  this->DefWndProc(SCI_SETDOCPOINTER, 0, reinterpret_cast<sptr_t>(doc));
+  this->DefWndProc(SCI_SETLEXER, lexer, 0);
+  for (const std::pair<const std::string, std::string>& iter : properties) {
+    this->DefWndProc(SCI_SETPROPERTY, reinterpret_cast<uptr_t>(iter.first.c_str()),
+                     reinterpret_cast<sptr_t>(iter.second.c_str()));
+  }
+  for (size_t i = 0; i < keywords.size(); i++) {
+    this->DefWndProc(SCI_SETKEYWORDS, i, reinterpret_cast<sptr_t>(keywords[i].c_str()));
+  }
+}
+
 sptr_t ScintillaAWTK::DefWndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
+  sptr_t lexer = 0;
+  sptr_t ret = 0;
+
+  /*记下设置给词法分析器的属性和关键字，后台词法分析时在新的实例上重放。*/
+  switch (iMessage) {
+    case SCI_SETDOCPOINTER: {
+      this->lex_properties.clear();
+      this->lex_keywords.clear();
+      break;
+    }
+    case SCI_SETPROPERTY: {
+      if (wParam != 0 && lParam != 0) {
+        this->lex_properties[ConstCharPtrFromUPtr(wParam)] = ConstCharPtrFromSPtr(lParam);
+      }
+      /*进行中的后台分析使用的是原来的属性和关键字，结果作废，在idle中重新开始。*/
+      if (this->lex_job != NULL) {
+        this->RequestBackgroundLexing();
+      }
+      break;
+    }
+    case SCI_SETKEYWORDS: {
+      if (wParam <= KEYWORDSET_MAX && lParam != 0) {
+        this->lex_keywords.resize(tk_max(this->lex_keywords.size(), wParam + 1));
+        this->lex_keywords[wParam] = ConstCharPtrFromSPtr(lParam);
+      }
+      if (this->lex_job != NULL) {
+        this->RequestBackgroundLexing();
+      }
+      break;
+    }
+    case SCI_SETLEXER:
+    case SCI_SETLEXERLANGUAGE: {
+      lexer = ScintillaBase::WndProc(SCI_GETLEXER, 0, 0);
+      ret = ScintillaBase::WndProc(iMessage, wParam, lParam);
+      if (lexer != ScintillaBase::WndProc(SCI_GETLEXER, 0, 0)) {
+        this->lex_keywords.clear();
+      }
+      return ret;
+    }
+    default:
+      break;
+  }
+
   return ScintillaBase::WndProc(iMessage, wParam, lParam);
 }
 
 void ScintillaAWTK::OnPaint(widget_t* widget, canvas_t* c) {
-  std::unique_ptr<Surface> surfaceWindow(Surface::Allocate(SC_TECHNOLOGY_DEFAULT));
+  rect_t clip;
+  SurfaceStats before;
+  SurfaceStats after;
+  double styling_duration = 0;
+  Sci::Line styling_lines = 0;
+
+  this->painted = true;
 
-  surfaceWindow->Init(c, widget);
+  /*Surface在多次绘制间复用，每帧只重新绑定canvas，保留其缓冲区和字体状态。*/
+  if (this->surface == nullptr) {
+    this->surface.reset(Surface::Allocate(SC_TECHNOLOGY_DEFAULT));
+  }
+  this->surface->Init(c, widget);
   rcPaint = this->GetClientRectangle();
-  this->Paint(surfaceWindow.get(), rcPaint);
+  this->damage = rect_init(0, 0, 0, 0);
+  this->invalidated = rect_init(0, 0, 0, 0);
+
+  /*只绘制裁剪区内的行，裁剪区由AWTK根据脏区设置。*/
+  if (canvas_get_clip_rect(c, &clip) == RET_OK) {
+    PRectangle rcClip = PRectangle::FromInts(clip.x - c->ox, clip.y - c->oy,
+                                             clip.x - c->ox + clip.w, clip.y - c->oy + clip.h);
+    const PRectangle rcClient = rcPaint;
+
+    rcPaint.left = std::max(rcClient.left, rcClip.left);
+    rcPaint.top = std::max(rcClient.top, rcClip.top);
+    rcPaint.right = std::min(rcClient.right, rcClip.right);
+    rcPaint.bottom = std::min(rcClient.bottom, rcClip.bottom);
+    if (rcPaint.Empty()) {
+      this->surface->Release();
+      return;
+    }
+    paintingAllText = rcPaint.Contains(rcClient);
+  } else {
+    paintingAllText = true;
+  }
+
+  SurfaceGetStats(this->surface.get(), &before);
+  styling_duration = pdoc->durationStyling;
+  styling_lines = pdoc->linesStyled;
+
+  paintState = painting;
+  this->Paint(this->surface.get(), rcPaint);
+  if (paintState == paintAbandoned) {
+    this->AddDamage(this->GetClientRectangle());
+  }
+  paintState = notPainting;
+
+  this->NotifyStyling(pdoc->durationStyling - styling_duration,
+                      pdoc->linesStyled - styling_lines, false);
+
+  this->surface->Release();
+
+  /*Release时会提交合并后的填充，之后再统计本帧的数据。*/
+  SurfaceGetStats(this->surface.get(), &after);
+  this->frame_stats.fontSwitches = after.fontSwitches - before.fontSwitches;
+  this->frame_stats.fillRequests = after.fillRequests - before.fillRequests;
+  this->frame_stats.fills = after.fills - before.fills;
+  this->frame_stats.fillsElided = after.fillsElided - before.fillsElided;
+}
+
+/*只读映射的文件，文档销毁时解除映射。*/
+class MappedText : public IExternalText {
+ public:
+  explicit MappedText(mmap_t* map_) noexcept : map(map_) {
+  }
+  virtual ~MappedText() {
+    mmap_destroy(this->map);
+  }
+  virtual const char* Data() const noexcept override {
+    return (const char*)(this->map->data);
+  }
+  virtual Sci::Position Length() const noexcept override {
+    return this->map->size;
+  }
+
+ private:
+  mmap_t* map;
+};
+
+ret_t ScintillaAWTK::OnFramePainted(void* ctx, event_t* e) {
+  ScintillaAWTK* sciThis = static_cast<ScintillaAWTK*>(ctx);
+
+  /*编辑器没有脏区时AWTK不会调用它的OnPaint，这一帧记为跳过。*/
+  if (!sciThis->painted) {
+    sciThis->skipped_frames++;
+  }
+  sciThis->painted = false;
+
+  return RET_OK;
+}
+
+uint32_t ScintillaAWTK::GetSkippedFrames(void) const {
+  return this->skipped_frames;
+}
+
+uint32_t ScintillaAWTK::GetRedrawRequests(void) const {
+  return this->redraw_requests;
+}
+
+uint32_t ScintillaAWTK::GetGeneration(void) const {
+  return this->generation;
+}
+
+void ScintillaAWTK::SetListener(ScintillaAWTKListener* listener) {
+  this->listener.reset(listener);
+}
+
+void ScintillaAWTK::SetStylingBudget(uint32_t us) {
+  /*0表示使用Scintilla的默认预算(滚动时5ms，其它情况20ms)。*/
+  stylingBudget = us / 1000000.0;
+}
+
+void ScintillaAWTK::NotifyStyling(double duration, Sci::Line lines, bool idle) {
+  if (lines <= 0 && duration <= 0) {
+    return;
+  }
+
+  if (this->listener) {
+    this->listener->OnStyling(duration, lines, pdoc->GetEndStyled(), pdoc->Length(), idle);
+  }
+}
+
+/*小于这个大小的文档直接在UI线程中分析，不值得启动后台任务。*/
+#define LEX_JOB_MIN_SIZE (64 * 1024)
+
+/*工作线程每次分析的字节数，取消时最多等待一块。*/
+#define LEX_JOB_CHUNK_SIZE (256 * 1024)
+
+/*UI线程每次idle复制到后台任务的字节数，分多次复制，避免在一帧内复制整个文档。*/
+#define LEX_JOB_COPY_SIZE (1024 * 1024)
+
+/*UI线程每次idle合并的字节数，也是合并后UI线程的词法分析器每次idle补上状态的字节数。*/
+#define LEX_JOB_MERGE_SIZE (64 * 1024)
+
+/*文档不小于这个大小且词法分析器声明了lpcConvergent时，分块在多个线程中并行分析。*/
+#define LEX_JOB_PARALLEL_SIZE (1024 * 1024)
+
+/*并行分析时每块的最小字节数，块太小时接缝处重新分析的开销占比太大。*/
+#define LEX_JOB_PARALLEL_CHUNK_SIZE (256 * 1024)
+
+/*并行分析最多使用的线程数。*/
+#define LEX_JOB_MAX_THREADS 8
+
+/*从分块的目标位置向后查找空行的最大距离，找不到时在下一行行首分块。*/
+#define LEX_JOB_SEAM_SEARCH (64 * 1024)
+
+/*块的Document中在分析的位置之后多放的文本，词法分析和折叠可能会查看后面的行。*/
+#define LEX_JOB_LOOKAHEAD (64 * 1024)
+
+/*块的前缀最多的字节数，接缝处的上文比这更长时不在这里分块，与前一块合并。*/
+#define LEX_JOB_PREFIX_SIZE (64 * 1024)
+
+/*在下一块中接着分析以对齐接缝的字节数，超过后仍没有对齐就从这里起顺序分析。*/
+#define LEX_JOB_RECONCILE_SIZE (256 * 1024)
+
+class LexJob;
+
+/*
+ * 并行分析的一块。块的Document中依次是前缀、本块和下一块的文本：前缀由之前的文本生成，
+ * 使块开始时的状态尽量与整个文档中一致；下一块的文本按需追加，用于在本块之后继续分析，
+ * 对齐接缝。
+ *
+ * Document中每字节文本另有1字节样式，每行另有行首、行状态和折叠级别。块的文本最多是
+ * LEX_JOB_PREFIX_SIZE的前缀、本块、LEX_JOB_RECONCILE_SIZE(最后一段分析的行数加倍，最多
+ * 约为两倍)的下一块和LEX_JOB_LOOKAHEAD，各块合计比顺序分析多出的部分与块数成正比，与文档
+ * 大小无关。接缝没有对齐时，该块的Document会增长到包含文档余下的部分，这时其它块的Document
+ * 已经释放，与顺序分析时的Document一样大。
+ */
+class LexChunk {
+ public:
+  LexJob* job;
+  Sci::Position start;
+  Sci::Position end;
+  Sci::Position limit;
+  Sci::Position appended;
+  std::string prefix;
+  Sci::Line prefixLines;
+  Sci::Line lines;
+  Sci::Line reconciled;
+  std::vector<int> lineStates;
+  std::vector<int> levels;
+  ILexer* lexer;
+  Document* doc;
+  bool ok;
+  tk_thread_t* thread;
+
+  LexChunk() : job(NULL), start(0), end(0), limit(0), appended(0), prefixLines(0), lines(0),
+               reconciled(0), lexer(NULL), doc(NULL), ok(false), thread(NULL) {
+  }
+
+  ~LexChunk() {
+    this->Release();
+  }
+
+  void Release(void) {
+    if (this->doc != NULL) {
+      this->doc->Release();
+      this->doc = NULL;
+    }
+    if (this->lexer != NULL) {
+      this->lexer->Release();
+      this->lexer = NULL;
+    }
+  }
+};
+
+/*行尾(换行符之前)是反斜杠时下一行是这一行的延续。*/
+static bool IsContinuedLine(const char* s, Sci::Position lineStart, Sci::Position lineEnd) {
+  Sci::Position i = lineEnd;
+
+  if (i > lineStart && s[i - 1] == '\n') {
+    i--;
+  }
+  if (i > lineStart && s[i - 1] == '\r') {
+    i--;
+  }
+
+  return i > lineStart && s[i - 1] == '\\';
+}
+
+/*line开始的一行是预处理指令word时返回true，如#  if。*/
+static bool IsDirective(const char* line, const char* end, const char* word) {
+  const char* p = line;
+  const size_t len = strlen(word);
+
+  while (p < end && (*p == ' ' || *p == '\t')) {
+    p++;
+  }
+  if (p >= end || *p != '#') {
+    return false;
+  }
+  for (p++; p < end && (*p == ' ' || *p == '\t'); p++) {
+  }
+
+  return (size_t)(end - p) >= len && memcmp(p, word, len) == 0 &&
+         (p + len == end || (!isalnum((unsigned char)p[len]) && p[len] != '_'));
+}
+
+/*
+ * 上文最后一行是#endif时，如果与之配对的条件块中没有#define和#undef，这个块不影响之后的分析，
+ * 从上文中去掉。这样上文中只剩下宏定义和还没有闭合的条件，不随文档增长。
+ */
+static void DropClosedConditional(std::string* context) {
+  const char* s = context->c_str();
+  size_t end = context->size();
+  int32_t depth = 0;
+
+  while (end > 0) {
+    const char* eol = s + end;
+    size_t start = end - 1;
+
+    while (start > 0 && s[start - 1] != '\n') {
+      start--;
+    }
+    if (IsDirective(s + start, eol, "endif")) {
+      depth++;
+    } else if (IsDirective(s + start, eol, "if") || IsDirective(s + start, eol, "ifdef") ||
+               IsDirective(s + start, eol, "ifndef")) {
+      depth--;
+    } else if (IsDirective(s + start, eol, "define") || IsDirective(s + start, eol, "undef")) {
+      return;
+    }
+    if (depth <= 0) {
+      if (depth == 0) {
+        context->erase(start);
+      }
+      return;
+    }
+    end = start;
+  }
+}
+
+/*后台词法分析任务：在工作线程中对文档的快照做词法分析，完成后由UI线程合并结果。*/
+class LexJob {
+ public:
+  int lexLanguage;
+  int codePage;
+  uint32_t threads;
+  uint32_t generation;
+  std::vector<std::pair<std::string, std::string> > properties;
+  std::vector<std::string> keywords;
+  /*
+   * 文档的快照，由UI线程在idle中分段复制。顺序分析时直接复制到doc中，结果也留在doc中，
+   * 不再另外保存一份文本；并行分析需要随机访问全文，复制到text中。
+   */
+  Document* doc;
+  std::string text;
+  Sci::Position length;
+  Sci::Position copied;
+  std::vector<char> slice;
+  std::vector<char> styles;
+  std::vector<int> lineStates;
+  std::vector<int> levels;
+  std::atomic<bool> canceled;
+  std::atomic<bool> finished;
+  bool ok;
+  uint32_t chunks;
+  Sci::Position merged;
+  tk_thread_t* thread;
+
+  LexJob() : lexLanguage(SCLEX_NULL), codePage(0), threads(1), generation(0), doc(NULL),
+             length(0), copied(0), canceled(false), finished(false), ok(false), chunks(0),
+             merged(0), thread(NULL) {
+  }
+
+  ~LexJob() {
+    if (this->doc != NULL) {
+      this->doc->Release();
+    }
+  }
+
+  void Run(void) {
+    ILexer* lexer = NULL;
+
+    try {
+      lexer = this->CreateLexer();
+      if (lexer != NULL && this->doc == NULL && !this->LexParallel(lexer) && !this->canceled) {
+        this->doc = this->CreateDocument(NULL, 0, this->text.size());
+        std::string().swap(this->text);
+      }
+      if (lexer != NULL && this->doc != NULL) {
+        this->ok = this->LexRange(lexer, this->doc, 0, this->doc->Length());
+      }
+    } catch (...) {
+      this->ok = false;
+    }
+
+    if (lexer != NULL) {
+      lexer->Release();
+    }
+    this->finished = true;
+  }
+
+  /*分析结果：顺序分析的结果在doc中，并行分析的结果在styles、lineStates和levels中。*/
+  Sci::Position ResultLength(void) const {
+    return this->doc != NULL ? this->doc->Length() : this->styles.size();
+  }
+
+  Sci::Line ResultLines(void) const {
+    return this->doc != NULL ? this->doc->LinesTotal() : this->levels.size();
+  }
+
+  int ResultLineState(Sci::Line line) const {
+    return this->doc != NULL ? this->doc->GetLineState(line) : this->lineStates[line];
+  }
+
+  int ResultLevel(Sci::Line line) const {
+    return this->doc != NULL ? this->doc->GetLevel(line) : this->levels[line];
+  }
+
+  const char* ResultStyles(Sci::Position pos, Sci::Position length) {
+    if (this->doc == NULL) {
+      return &this->styles[pos];
+    }
+
+    this->slice.resize(length);
+    this->doc->GetStyleRange(reinterpret_cast<unsigned char*>(&this->slice[0]), pos, length);
+
+    return &this->slice[0];
+  }
+
+  Document* CreateDocument(const std::string* prefix, Sci::Position start, Sci::Position end) {
+    Document* doc = new Document(SC_DOCUMENTOPTION_DEFAULT);
+
+    doc->AddRef();
+    try {
+      doc->SetUndoCollection(false);
+      doc->SetDBCSCodePage(this->codePage);
+      if (prefix != NULL && !prefix->empty()) {
+        doc->InsertString(0, prefix->c_str(), prefix->size());
+      }
+      if (end > start) {
+        doc->InsertString(doc->Length(), this->text.c_str() + start, end - start);
+      }
+    } catch (...) {
+      doc->Release();
+      throw;
+    }
+
+    return doc;
+  }
+
+  void StyleChunk(LexChunk* c) {
+    const Sci::Position length = c->prefix.size() + (c->end - c->start);
+
+    try {
+      c->lexer = this->CreateLexer();
+      if (c->lexer == NULL) {
+        return;
+      }
+      c->doc = this->CreateDocument(&(c->prefix), c->start, c->end);
+      c->appended = c->end;
+      this->AppendText(c, c->end + LEX_JOB_LOOKAHEAD);
+      c->prefixLines = c->doc->SciLineFromPosition(c->prefix.size());
+      c->lines = (c->end < c->limit ? c->doc->SciLineFromPosition(length) : c->doc->LinesTotal()) -
+                 c->prefixLines;
+      c->reconciled = c->prefixLines + c->lines;
+      if (!this->LexRange(c->lexer, c->doc, 0, length)) {
+        return;
+      }
+
+      /*各块的样式直接写到结果的对应位置，行状态和折叠级别最后按顺序拼接。*/
+      if (c->end > c->start) {
+        c->doc->GetStyleRange(reinterpret_cast<unsigned char*>(&this->styles[c->start]),
+                              c->prefix.size(), c->end - c->start);
+      }
+      c->lineStates.resize(c->lines);
+      c->levels.resize(c->lines);
+      for (Sci::Line i = 0; i < c->lines; i++) {
+        c->lineStates[i] = c->doc->GetLineState(c->prefixLines + i);
+        c->levels[i] = c->doc->GetLevel(c->prefixLines + i);
+      }
+      c->ok = true;
+    } catch (...) {
+      c->ok = false;
+    }
+  }
+
+  /*
+   * 用本块的词法分析器接着分析下一块的开头，直到某行末尾的样式、行状态和折叠级别与下一块
+   * 独立分析的结果一致，之后的结果与从文档开头分析的相同。本块的状态在接缝处是正确的，
+   * 前提是前一个接缝已经在本块内对齐。在下一块中分析了LEX_JOB_RECONCILE_SIZE或到下一块末尾
+   * 都没有对齐时返回失败，reconciled是接着分析到的行，之前的结果已经写到下一块中，都是正确的。
+   */
+  void ReconcileChunk(LexChunk* c, LexChunk* next) {
+    Document* doc = c->doc;
+    const Sci::Line first = c->prefixLines + c->lines;
+    const Sci::Line last = first + next->lines;
+    const Sci::Position offset = next->start - doc->LineStart(first);
+    Sci::Line line = first;
+    Sci::Line run = 1;
+
+    c->ok = false;
+    try {
+      while (line < last && !this->canceled &&
+             doc->LineStart(line) - doc->LineStart(first) < LEX_JOB_RECONCILE_SIZE) {
+        const Sci::Line lineEnd = std::min(line + run, last);
+        Sci::Position pos = 0;
+        Sci::Position posEnd = 0;
+        const Sci::Line lineLast = lineEnd - 1 - first;
+        int initStyle = 0;
+        bool same = false;
+
+        while (c->appended < c->limit && (doc->LinesTotal() <= lineEnd ||
+                                          doc->Length() - doc->LineStart(lineEnd) < LEX_JOB_LOOKAHEAD)) {
+          this->AppendText(c, c->appended + LEX_JOB_LOOKAHEAD);
+        }
+        pos = doc->LineStart(line);
+        posEnd = doc->LineStart(lineEnd);
+        initStyle = pos > 0 ? doc->StyleIndexAt(pos - 1) : 0;
+
+        c->lexer->Lex(pos, posEnd - pos, initStyle, doc);
+        c->lexer->Fold(pos, posEnd - pos, initStyle, doc);
+
+        same = doc->GetLineState(lineEnd - 1) == next->lineStates[lineLast] &&
+               doc->GetLevel(lineEnd - 1) == next->levels[lineLast] &&
+               (posEnd == pos || doc->StyleAt(posEnd - 1) == this->styles[posEnd - 1 + offset]);
+
+        if (posEnd > pos) {
+          doc->GetStyleRange(reinterpret_cast<unsigned char*>(&this->styles[pos + offset]), pos,
+                             posEnd - pos);
+        }
+        for (Sci::Line i = line; i < lineEnd; i++) {
+          next->lineStates[i - first] = doc->GetLineState(i);
+          next->levels[i - first] = doc->GetLevel(i);
+        }
+
+        c->reconciled = lineEnd;
+        if (same) {
+          c->ok = true;
+          return;
+        }
+        line = lineEnd;
+        run = std::min<Sci::Line>(run * 2, 0x10000);
+      }
+    } catch (...) {
+      c->ok = false;
+    }
+  }
+
+  /*
+   * 接缝没有对齐时用本块的词法分析器从reconciled起顺序分析到文档末尾，Document和词法分析器中
+   * 的状态(如JSON括号的层数)都接着本块，不需要前缀。
+   */
+  bool ContinueChunk(LexChunk* c) {
+    Document* doc = c->doc;
+    const Sci::Line first = c->prefixLines + c->lines;
+    const Sci::Position offset = c->end - doc->LineStart(first);
+    const Sci::Position pos = doc->LineStart(c->reconciled);
+
+    try {
+      c->limit = this->text.size();
+      this->AppendText(c, c->limit);
+      if (!this->LexRange(c->lexer, doc, pos, doc->Length())) {
+        return false;
+      }
+      if (doc->Length() > pos) {
+        doc->GetStyleRange(reinterpret_cast<unsigned char*>(&this->styles[pos + offset]), pos,
+                           doc->Length() - pos);
+      }
+    } catch (...) {
+      return false;
+    }
+
+    return true;
+  }
+
+ private:
+  /*在块的Document末尾追加下一块的文本，到upTo之后的行首为止。*/
+  void AppendText(LexChunk* c, Sci::Position upTo) {
+    const char* s = this->text.c_str();
+    Sci::Position end = std::min(upTo, c->limit);
+
+    if (end < c->limit) {
+      const char* eol = static_cast<const char*>(memchr(s + end, '\n', c->limit - end));
+      end = eol != NULL ? eol - s + 1 : c->limit;
+    }
+    if (end > c->appended) {
+      c->doc->InsertString(c->doc->Length(), s + c->appended, end - c->appended);
+      c->appended = end;
+    }
+  }
+
+  ILexer* CreateLexer(void) {
+    const LexerModule* lm = Catalogue::Find(this->lexLanguage);
+    ILexer* lexer = lm != NULL ? lm->Create() : NULL;
+
+    if (lexer != NULL) {
+      for (size_t i = 0; i < this->properties.size(); i++) {
+        lexer->PropertySet(this->properties[i].first.c_str(), this->properties[i].second.c_str());
+      }
+      for (size_t i = 0; i < this->keywords.size(); i++) {
+        lexer->WordListSet(i, this->keywords[i].c_str());
+      }
+    }
+
+    return lexer;
+  }
+
+  /*与LexInterface::Colourise一样按行分块分析，结果与UI线程中的增量分析相同。*/
+  bool LexRange(ILexer* lexer, Document* doc, Sci::Position pos, Sci::Position length) {
+    while (pos < length) {
+      const Sci::Line line = doc->SciLineFromPosition(pos + LEX_JOB_CHUNK_SIZE);
+      const Sci::Position end = std::min(doc->LineStart(line + 1), length);
+      const int initStyle = pos > 0 ? doc->StyleIndexAt(pos - 1) : 0;
+
+      if (this->canceled) {
+        return false;
+      }
+      lexer->Lex(pos, end - pos, initStyle, doc);
+      lexer->Fold(pos, end - pos, initStyle, doc);
+      pos = end;
+    }
+
+    return true;
+  }
+
+  /*
+   * 优先在空行之后、从第一列开始的行(如顶层的函数定义)处分块，这里通常不在注释、字符串或
+   * 括号中，接缝处的分析状态和折叠级别最容易对齐。找不到时退而使用任意空行或下一行行首。
+   */
+  Sci::Position FindSeam(Sci::Position pos) const {
+    const Sci::Position length = this->text.size();
+    const Sci::Position limit = std::min<Sci::Position>(pos + LEX_JOB_SEAM_SEARCH, length);
+    const char* s = this->text.c_str();
+    const char* eol = static_cast<const char*>(memchr(s + pos, '\n', length - pos));
+    Sci::Position lineStart = 0;
+    Sci::Position afterBlank = 0;
+
+    if (eol == NULL) {
+      return length;
+    }
+    lineStart = eol - s + 1;
+    for (Sci::Position i = lineStart; i < limit; i++) {
+      if (s[i - 1] == '\n' && (s[i] == '\n' || (s[i] == '\r' && i + 1 < length && s[i + 1] == '\n'))) {
+        const Sci::Position next = s[i] == '\n' ? i + 1 : i + 2;
+        if (next < length && s[next] != ' ' && s[next] != '\t' && s[next] != '\r' &&
+            s[next] != '\n') {
+          return next;
+        } else if (afterBlank == 0) {
+          afterBlank = next;
+        }
+      }
+    }
+
+    return afterBlank > 0 ? afterBlank : lineStart;
+  }
+
+  /*C/C++：预处理条件和宏定义会影响之后所有行的分析，上文是之前的预处理指令。*/
+  void AppendDirectives(Sci::Position start, Sci::Position end, std::string* context) const {
+    const char* s = this->text.c_str();
+    Sci::Position pos = start;
+
+    while (pos < end) {
+      const char* eol = static_cast<const char*>(memchr(s + pos, '\n', end - pos));
+      Sci::Position lineEnd = eol != NULL ? eol - s + 1 : end;
+      Sci::Position i = pos;
+
+      while (i < lineEnd && (s[i] == ' ' || s[i] == '\t')) {
+        i++;
+      }
+      if (i < lineEnd && s[i] == '#') {
+        /*指令可能用反斜杠续行。*/
+        while (lineEnd < end && IsContinuedLine(s, pos, lineEnd)) {
+          eol = static_cast<const char*>(memchr(s + lineEnd, '\n', end - lineEnd));
+          lineEnd = eol != NULL ? eol - s + 1 : end;
+        }
+        context->append(s + pos, lineEnd - pos);
+        if (s[lineEnd - 1] != '\n') {
+          context->append("\n");
+        }
+        if (IsDirective(s + pos, s + lineEnd, "endif")) {
+          DropClosedConditional(context);
+        }
+      }
+      pos = lineEnd;
+    }
+  }
+
+  /*JSON：折叠级别是括号的嵌套层数，上文是还没有闭合的括号。*/
+  void UpdateBrackets(Sci::Position start, Sci::Position end, std::string* context) const {
+    const char* s = this->text.c_str();
+    bool inString = false;
+
+    for (Sci::Position i = start; i < end; i++) {
+      const char ch = s[i];
+      if (inString) {
+        if (ch == '\\') {
+          i++;
+        } else if (ch == '"' || ch == '\n') {
+          inString = false;
+        }
+      } else if (ch == '"') {
+        inString = true;
+      } else if (ch == '[' || ch == '{') {
+        context->push_back(ch);
+      } else if ((ch == ']' || ch == '}') && !context->empty()) {
+        context->erase(context->size() - 1);
+      }
+    }
+  }
+
+  /*块开始时需要的上文，按块的顺序调用，context中保存到end为止的状态。*/
+  void UpdateContext(Sci::Position start, Sci::Position end, std::string* context) const {
+    if (this->lexLanguage == SCLEX_CPP || this->lexLanguage == SCLEX_CPPNOCASE) {
+      this->AppendDirectives(start, end, context);
+    } else if (this->lexLanguage == SCLEX_JSON) {
+      this->UpdateBrackets(start, end, context);
+    }
+  }
+
+  /*由上文生成块的前缀，前缀以空行结束，与块开头之前的空行一致。*/
+  std::string ContextPrefix(const std::string& context) const {
+    std::string prefix;
+
+    if (this->lexLanguage == SCLEX_JSON) {
+      for (size_t i = 0; i < context.size(); i++) {
+        prefix.push_back(context[i]);
+        prefix.push_back('\n');
+      }
+    } else {
+      prefix = context;
+    }
+    if (!prefix.empty()) {
+      prefix.push_back('\n');
+    }
+
+    return prefix;
+  }
+
+  bool LexParallel(ILexer* lexer);
+};
+
+static void* LexChunkThread(void* args) {
+  LexChunk* c = static_cast<LexChunk*>(args);
+  c->job->StyleChunk(c);
+  return NULL;
+}
+
+static void* ReconcileChunkThread(void* args) {
+  LexChunk* c = static_cast<LexChunk*>(args);
+  c->job->ReconcileChunk(c, c + 1);
+  return NULL;
+}
+
+/*每块一个线程，创建线程失败时在当前线程中处理。*/
+static void RunLexChunks(LexChunk* chunks, size_t n, tk_thread_entry_t entry) {
+  for (size_t i = 0; i < n; i++) {
+    chunks[i].thread = tk_thread_create(entry, chunks + i);
+    if (chunks[i].thread != NULL && tk_thread_start(chunks[i].thread) != RET_OK) {
+      tk_thread_destroy(chunks[i].thread);
+      chunks[i].thread = NULL;
+    }
+    if (chunks[i].thread == NULL) {
+      entry(chunks + i);
+    }
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (chunks[i].thread != NULL) {
+      tk_thread_join(chunks[i].thread);
+      tk_thread_destroy(chunks[i].thread);
+      chunks[i].thread = NULL;
+    }
+  }
+}
+
+/*
+ * 并行分析：在空行处把文档分成几块，每块用独立的词法分析器从前缀的状态开始分析，再让每块的
+ * 分析器接着分析下一块的开头，直到结果与下一块的对齐。只适用于分析状态都保存在文档中的
+ * 词法分析器(lpcConvergent)。某个接缝没有对齐时保留之前的结果，用前一块的词法分析器从那里
+ * 顺序分析到末尾；第一块也失败时返回false，由调用者顺序分析整个文档。
+ */
+bool LexJob::LexParallel(ILexer* lexer) {
+  const Sci::Position length = this->text.size();
+  uint32_t n = std::min<uint32_t>(this->threads, LEX_JOB_MAX_THREADS);
+  std::vector<Sci::Position> seams;
+  std::vector<std::string> prefixes;
+  std::unique_ptr<LexChunk[]> chunks;
+  std::string context;
+  Sci::Position from = 0;
+  Sci::Line lines = 0;
+  uint32_t failed = 0;
+  uint32_t kept = 0;
+
+  if (length < LEX_JOB_PARALLEL_SIZE || lexer->PrivateCall(lpcConvergent, NULL) == NULL) {
+    return false;
+  }
+
+  n = std::min<uint32_t>(n, length / LEX_JOB_PARALLEL_CHUNK_SIZE);
+  seams.push_back(0);
+  for (uint32_t i = 1; i < n; i++) {
+    const Sci::Position seam = this->FindSeam(length / n * i);
+    if (seam > seams.back() && seam < length) {
+      seams.push_back(seam);
+    }
+  }
+  seams.push_back(length);
+
+  /*上文太长的接缝不用，前后两块合并。*/
+  prefixes.push_back(std::string());
+  for (size_t i = 1; i + 1 < seams.size();) {
+    this->UpdateContext(from, seams[i], &context);
+    from = seams[i];
+    prefixes.push_back(this->ContextPrefix(context));
+    if (prefixes.back().size() > LEX_JOB_PREFIX_SIZE) {
+      prefixes.pop_back();
+      seams.erase(seams.begin() + i);
+    } else {
+      i++;
+    }
+  }
+  if (seams.size() < 3) {
+    return false;
+  }
+
+  n = seams.size() - 1;
+  chunks.reset(new LexChunk[n]);
+  this->styles.resize(length);
+  for (uint32_t i = 0; i < n; i++) {
+    LexChunk* c = &chunks[i];
+    c->job = this;
+    c->start = seams[i];
+    c->end = seams[i + 1];
+    c->limit = i + 2 < seams.size() ? seams[i + 2] : length;
+    c->prefix.swap(prefixes[i]);
+  }
+
+  RunLexChunks(&chunks[0], n, LexChunkThread);
+  if (!chunks[0].ok) {
+    return false;
+  }
+
+  /*只有第一个分析失败的块之前的接缝需要对齐，最后一块之后没有接缝。*/
+  for (failed = 1; failed < n && chunks[failed].ok; failed++) {
+  }
+  RunLexChunks(&chunks[0], failed - 1, ReconcileChunkThread);
+  if (this->canceled) {
+    return false;
+  }
+  for (kept = 1; kept < failed && chunks[kept - 1].ok; kept++) {
+  }
+
+  /*第kept个接缝没有对齐：之后各块的结果不用，用前一块接着顺序分析。*/
+  if (kept < n) {
+    LexChunk* c = &chunks[kept - 1];
+    for (uint32_t i = kept; i < n; i++) {
+      chunks[i].Release();
+    }
+    if (!this->ContinueChunk(c)) {
+      return false;
+    }
+    c->lineStates.resize(c->lines);
+    c->levels.resize(c->lines);
+    for (Sci::Line i = c->prefixLines + c->lines; i < c->doc->LinesTotal(); i++) {
+      c->lineStates.push_back(c->doc->GetLineState(i));
+      c->levels.push_back(c->doc->GetLevel(i));
+    }
+    c->lines = c->lineStates.size();
+  }
+
+  for (uint32_t i = 0; i < kept; i++) {
+    lines += chunks[i].lines;
+  }
+  this->lineStates.reserve(lines);
+  this->levels.reserve(lines);
+  for (uint32_t i = 0; i < kept; i++) {
+    this->lineStates.insert(this->lineStates.end(), chunks[i].lineStates.begin(),
+                            chunks[i].lineStates.end());
+    this->levels.insert(this->levels.end(), chunks[i].levels.begin(), chunks[i].levels.end());
+  }
+  std::string().swap(this->text);
+  this->chunks = kept;
+  this->ok = true;
+
+  return true;
+}
+
+static void* LexJobThread(void* args) {
+  static_cast<LexJob*>(args)->Run();
+  return NULL;
+}
+
+void ScintillaAWTK::SetBackgroundLexing(bool on) {
+  this->background_lexing = on;
+  if (on) {
+    this->RequestBackgroundLexing();
+  } else {
+    this->CancelLexJob();
+  }
+}
+
+void ScintillaAWTK::SetLexThreads(uint32_t threads) {
+  this->lex_threads = threads;
+}
 
-  surfaceWindow->Release();
+uint32_t ScintillaAWTK::GetLexChunks(void) const {
+  return this->lex_chunks;
+}
+
+bool ScintillaAWTK::IsBackgroundLexing(void) const {
+  return this->lex_requested || this->lex_job != NULL;
+}
+
+void ScintillaAWTK::RequestBackgroundLexing(void) {
+  if (!this->background_lexing) {
+    return;
+  }
+
+  /*同一帧内的多次请求(如替换文档后再设置语言)合并为一次，在idle中启动。*/
+  this->lex_requested = true;
+  if (this->lex_idle_id == TK_INVALID_ID) {
+    this->lex_idle_id = idle_add(OnLexIdle, this);
+  }
+}
+
+void ScintillaAWTK::StartLexJob(void) {
+  const Sci::Position length = pdoc->Length();
+  const int lexer = ScintillaBase::WndProc(SCI_GETLEXER, 0, 0);
+  LexJob* job = NULL;
+
+  if (length < LEX_JOB_MIN_SIZE || pdoc->GetEndStyled() >= length || lexer == SCLEX_NULL ||
+      lexer == SCLEX_CONTAINER) {
+    return;
+  }
+
+  try {
+    job = new LexJob();
+    job->lexLanguage = lexer;
+    job->codePage = pdoc->dbcsCodePage;
+    job->generation = this->generation;
+    /*0表示按CPU核数并行。*/
+    job->threads = this->lex_threads > 0 ? this->lex_threads : std::thread::hardware_concurrency();
+    job->properties.assign(this->lex_properties.begin(), this->lex_properties.end());
+    job->keywords = this->lex_keywords;
+    job->length = length;
+    /*快照在之后的idle中分段复制，复制完成后才启动工作线程。*/
+    if (length >= LEX_JOB_PARALLEL_SIZE && job->threads > 1 &&
+        ScintillaBase::WndProc(SCI_PRIVATELEXERCALL, lpcConvergent, 0) != 0) {
+      job->text.reserve(length);
+    } else {
+      job->doc = job->CreateDocument(NULL, 0, 0);
+    }
+  } catch (...) {
+    delete job;
+    return;
+  }
+
+  this->lex_job = job;
+}
+
+/*复制一段快照，复制完后启动工作线程。文档在复制期间被修改或无法启动线程时返回false。*/
+bool ScintillaAWTK::CopyLexJob(LexJob* job) {
+  const Sci::Position start = job->copied;
+  const Sci::Position end = std::min<Sci::Position>(start + LEX_JOB_COPY_SIZE, job->length);
+
+  if (job->generation != this->generation || job->length != pdoc->Length() ||
+      job->lexLanguage != ScintillaBase::WndProc(SCI_GETLEXER, 0, 0)) {
+    return false;
+  }
+
+  try {
+    job->slice.resize(end - start);
+    pdoc->GetCharRange(&job->slice[0], start, end - start);
+    if (job->doc != NULL) {
+      job->doc->InsertString(start, &job->slice[0], end - start);
+    } else {
+      job->text.append(&job->slice[0], end - start);
+    }
+  } catch (...) {
+    return false;
+  }
+  job->copied = end;
+  if (end < job->length) {
+    return true;
+  }
+
+  std::vector<char>().swap(job->slice);
+  job->thread = tk_thread_create(LexJobThread, job);
+  if (job->thread == NULL || tk_thread_start(job->thread) != RET_OK) {
+    if (job->thread != NULL) {
+      tk_thread_destroy(job->thread);
+      job->thread = NULL;
+    }
+    return false;
+  }
+
+  return true;
+}
+
+void ScintillaAWTK::CancelLexJob(void) {
+  LexJob* job = this->lex_job;
+
+  this->lex_job = NULL;
+  this->lex_requested = false;
+  if (this->lex_idle_id != TK_INVALID_ID) {
+    idle_remove(this->lex_idle_id);
+    this->lex_idle_id = TK_INVALID_ID;
+  }
+
+  if (job != NULL) {
+    job->canceled = true;
+    if (job->thread != NULL) {
+      tk_thread_join(job->thread);
+      tk_thread_destroy(job->thread);
+    }
+    delete job;
+  }
+}
+
+bool ScintillaAWTK::MergeLexJob(LexJob* job) {
+  const Sci::Position length = job->ResultLength();
+  const Sci::Line lines = job->ResultLines();
+  const Sci::Position endStyled = pdoc->GetEndStyled();
+  LexInterface* pli = pdoc->GetLexInterface();
+  Sci::Position start = job->merged;
+  Sci::Position end = 0;
+  Sci::Line lineStart = 0;
+  Sci::Line lineEnd = 0;
+
+  /*文档在分析期间被修改或更换了词法分析器，结果作废，仍由同步的增量分析负责。*/
+  if (!job->ok || job->generation != this->generation || length != pdoc->Length() ||
+      lines != pdoc->LinesTotal() || job->lexLanguage != ScintillaBase::WndProc(SCI_GETLEXER, 0, 0) ||
+      pli == NULL) {
+    return false;
+  }
+
+  /*UI线程已经分析过的部分(如可见区域)不再合并，合并也不会让endStyled后退。*/
+  if (start < endStyled) {
+    start = std::max(start, pdoc->LineStart(pdoc->SciLineFromPosition(endStyled)));
+  }
+
+  /*每次idle只合并一段(到行首为止)，避免在一帧内处理整个文档。*/
+  end = std::min<Sci::Position>(start + LEX_JOB_MERGE_SIZE, length);
+  if (end < length) {
+    end = std::min(pdoc->LineStart(pdoc->SciLineFromPosition(end) + 1), length);
+  }
+  lineStart = pdoc->SciLineFromPosition(start);
+  lineEnd = end < length ? pdoc->SciLineFromPosition(end) : lines;
+
+  /*
+   * 合并的结果不是UI线程的词法分析器分析的，它内部的状态(如LexCPP的预处理条件和宏定义)
+   * 只到start为止。之后在后面修改时先从start补上，合并完后也在空闲时逐段补上。
+   */
+  if (end > start) {
+    pli->InvalidateStateFrom(start);
+  }
+
+  this->BeginBatch();
+  for (Sci::Line i = lineStart; i < lineEnd; i++) {
+    pdoc->SetLineState(i, job->ResultLineState(i));
+    pdoc->SetLevel(i, job->ResultLevel(i));
+  }
+  if (end > start) {
+    pdoc->StartStyling(start, '\xff');
+    pdoc->SetStyles(end - start, job->ResultStyles(start, end - start));
+  }
+  this->EndBatch();
+  job->merged = end;
+  if (end >= length) {
+    this->lex_chunks = job->chunks;
+  }
+
+  return end < length;
+}
+
+ret_t ScintillaAWTK::OnLexIdle(const idle_info_t* info) {
+  ScintillaAWTK* sciThis = (ScintillaAWTK*)(info->ctx);
+  LexJob* job = sciThis->lex_job;
+
+  if (sciThis->lex_requested) {
+    sciThis->lex_requested = false;
+    if (job != NULL) {
+      sciThis->lex_idle_id = TK_INVALID_ID;
+      sciThis->CancelLexJob();
+    }
+    sciThis->StartLexJob();
+    job = sciThis->lex_job;
+  }
+
+  if (job == NULL) {
+    LexInterface* pli = sciThis->pdoc->GetLexInterface();
+
+    if (pli != NULL && pli->CatchUp(LEX_JOB_MERGE_SIZE)) {
+      return RET_REPEAT;
+    }
+    sciThis->lex_idle_id = TK_INVALID_ID;
+    return RET_REMOVE;
+  } else if (job->thread == NULL && !job->finished) {
+    if (!sciThis->CopyLexJob(job)) {
+      sciThis->lex_job = NULL;
+      delete job;
+    }
+    return RET_REPEAT;
+  } else if (!job->finished) {
+    return RET_REPEAT;
+  }
+
+  if (job->thread != NULL) {
+    tk_thread_join(job->thread);
+    tk_thread_destroy(job->thread);
+    job->thread = NULL;
+  }
+
+  if (sciThis->MergeLexJob(job)) {
+    return RET_REPEAT;
+  }
+
+  /*下一次idle开始补上UI线程的词法分析器的状态。*/
+  sciThis->lex_job = NULL;
+  delete job;
+
+  return RET_REPEAT;
+}
+
+uint32_t ScintillaAWTK::GetLinesLaidOut(void) const {
+  return this->view.linesLaidOut;
+}
+
+void ScintillaAWTK::SetMonospaceLayout(bool on) {
+  /*关闭后等宽字体也逐字测量，用于比较等宽快速路径的效果。已经排版的行需要重新排版。*/
+  if (this->view.posCache.monospaceLayout != on) {
+    this->view.posCache.monospaceLayout = on;
+    InvalidateStyleRedraw();
+  }
+}
+
+uint32_t ScintillaAWTK::GetMonospaceRuns(void) const {
+  return this->view.posCache.monospaceRuns;
+}
+
+const SurfaceStats& ScintillaAWTK::GetFrameStats(void) const {
+  return this->frame_stats;
+}
+
+ILoader* ScintillaAWTK::CreateLoader(Sci::Position bytes, int options) {
+  /*与SCI_CREATELOADER相同，但不访问编辑器的状态，可以在工作线程中调用。*/
+  try {
+    Document* doc = new Document(options);
+    doc->AddRef();
+    doc->SetUndoCollection(false);
+    try {
+      doc->Allocate(bytes);
+    } catch (...) {
+      doc->Release();
+      return NULL;
+    }
+    return static_cast<ILoader*>(doc);
+  } catch (...) {
+    return NULL;
+  }
+}
+
+ILoader* ScintillaAWTK::CreateMappedLoader(const char* filename) {
+  mmap_t* map = NULL;
+  return_value_if_fail(filename != NULL, NULL);
+
+  map = mmap_create(filename, FALSE, FALSE);
+  return_value_if_fail(map != NULL, NULL);
+
+  /*文本直接使用映射的内存，不分配文本和样式缓冲区，只在访问到的页面才会占用内存。*/
+  std::unique_ptr<IExternalText> text(new (std::nothrow) MappedText(map));
+  if (!text) {
+    mmap_destroy(map);
+    return NULL;
+  }
+
+  try {
+    int options = SC_DOCUMENTOPTION_STYLES_NONE;
+    if (text->Length() > INT32_MAX) {
+      options |= SC_DOCUMENTOPTION_TEXT_LARGE;
+    }
+
+    Document* doc = new Document(options);
+    doc->AddRef();
+    doc->SetExternalText(std::move(text));
+    return static_cast<ILoader*>(doc);
+  } catch (...) {
+    return NULL;
+  }
+}
+
+Sci::Position ScintillaAWTK::IndexMappedText(Sci::Position bytes) {
+  const Sci::Line lines = pdoc->LinesTotal();
+  const Sci::Position length = pdoc->Length();
+
+  /*分步建立当前映射文档的行索引，新找到的行追加到文档末尾，返回已经处理的字节数。*/
+  const Sci::Position indexed = pdoc->IndexExternalText(bytes);
+  if (indexed <= length) {
+    return indexed;
+  }
+
+  const Sci::Line added = pdoc->LinesTotal() - lines;
+  if (added > 0) {
+    pcs->InsertLines(lines, added);
+    view.LinesAddedOrRemoved(lines, added);
+  }
+
+  /*原来的最后一行变长了，它的布局需要重新计算。*/
+  view.llc.Invalidate(LineLayout::llCheckTextAndStyle);
+  NeedWrapping(lines - 1);
+  SetScrollBars();
+  Redraw();
+
+  return indexed;
+}
+
+/*按行比较时的一行：在文本中的范围和哈希值(包括换行符)。*/
+struct DiffLine {
+  Sci::Position start;
+  Sci::Position length;
+  uint32_t hash;
+};
+
+/*一处差异：旧文本中的[oldStart, oldEnd)行替换为新文本中的[newStart, newEnd)行。*/
+struct DiffHunk {
+  Sci::Line oldStart;
+  Sci::Line oldEnd;
+  Sci::Line newStart;
+  Sci::Line newEnd;
+};
+
+/*差异超过这个数量时不再求最小差异，把中间不同的部分整体替换。*/
+#define DIFF_MAX_EDITS 512
+
+static inline uint32_t DiffHash(uint32_t hash, unsigned char c) {
+  return (hash ^ c) * 16777619u;
+}
+
+static void DiffSplitText(const char* text, Sci::Position length, std::vector<DiffLine>& lines) {
+  DiffLine line = {0, 0, 2166136261u};
+
+  /*与文档的行索引一致：\n、\r\n和单独的\r都是行尾，最后一行可以为空。*/
+  for (Sci::Position i = 0; i < length; i++) {
+    const char c = text[i];
+    line.hash = DiffHash(line.hash, c);
+    if (c == '\n' || (c == '\r' && (i + 1 >= length || text[i + 1] != '\n'))) {
+      line.length = i + 1 - line.start;
+      lines.push_back(line);
+      line.start = i + 1;
+      line.hash = 2166136261u;
+    }
+  }
+
+  line.length = length - line.start;
+  lines.push_back(line);
+}
+
+static void DiffSplitDocument(const Document* pdoc, std::vector<DiffLine>& lines) {
+  const Sci::Line count = pdoc->LinesTotal();
+
+  lines.reserve(count);
+  for (Sci::Line i = 0; i < count; i++) {
+    DiffLine line;
+    line.start = pdoc->LineStart(i);
+    line.length = pdoc->LineStart(i + 1) - line.start;
+    line.hash = 2166136261u;
+    for (Sci::Position p = line.start; p < line.start + line.length; p++) {
+      line.hash = DiffHash(line.hash, pdoc->CharAt(p));
+    }
+    lines.push_back(line);
+  }
+}
+
+static bool DiffLineEquals(const Document* pdoc, const DiffLine& a, const char* text,
+                           const DiffLine& b) {
+  if (a.length != b.length || a.hash != b.hash) {
+    return false;
+  }
+
+  for (Sci::Position i = 0; i < a.length; i++) {
+    if (pdoc->CharAt(a.start + i) != text[b.start + i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*Myers差异算法，比较[a0, a1)和[b0, b1)，按从前往后的顺序输出差异，差异太多时返回false。*/
+static bool DiffMyers(const Document* pdoc, const std::vector<DiffLine>& a, Sci::Line a0,
+                      Sci::Line a1, const char* text, const std::vector<DiffLine>& b, Sci::Line b0,
+                      Sci::Line b1, std::vector<DiffHunk>& hunks) {
+  const Sci::Line n = a1 - a0;
+  const Sci::Line m = b1 - b0;
+  const Sci::Line max = std::min<Sci::Line>(n + m, DIFF_MAX_EDITS);
+  const Sci::Line offset = max + 1;
+  std::vector<Sci::Line> v(2 * max + 3, 0);
+  std::vector<std::vector<Sci::Line> > trace;
+  Sci::Line found = -1;
+
+  for (Sci::Line d = 0; d <= max && found < 0; d++) {
+    trace.push_back(v);
+    for (Sci::Line k = -d; k <= d; k += 2) {
+      Sci::Line x = 0;
+      Sci::Line y = 0;
+      if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) {
+        x = v[offset + k + 1];
+      } else {
+        x = v[offset + k - 1] + 1;
+      }
+      y = x - k;
+      while (x < n && y < m && DiffLineEquals(pdoc, a[a0 + x], text, b[b0 + y])) {
+        x++;
+        y++;
+      }
+      v[offset + k] = x;
+      if (x >= n && y >= m) {
+        found = d;
+        break;
+      }
+    }
+  }
+
+  if (found < 0) {
+    return false;
+  }
+
+  /*从终点回溯出每一步的插入或删除，再把相邻的合并为一处差异。*/
+  std::vector<DiffHunk> edits;
+  Sci::Line x = n;
+  Sci::Line y = m;
+  for (Sci::Line d = found; d > 0; d--) {
+    const std::vector<Sci::Line>& pv = trace[d];
+    const Sci::Line k = x - y;
+    const bool down = (k == -d || (k != d && pv[offset + k - 1] < pv[offset + k + 1]));
+    const Sci::Line pk = down ? k + 1 : k - 1;
+    const Sci::Line px = pv[offset + pk];
+    const Sci::Line py = px - pk;
+    DiffHunk edit = {a0 + px, a0 + px, b0 + py, b0 + py};
+
+    if (down) {
+      edit.newEnd++;
+    } else {
+      edit.oldEnd++;
+    }
+    edits.push_back(edit);
+    x = px;
+    y = py;
+  }
+
+  for (auto it = edits.rbegin(); it != edits.rend(); ++it) {
+    if (!hunks.empty() && hunks.back().oldEnd == it->oldStart &&
+        hunks.back().newEnd == it->newStart) {
+      hunks.back().oldEnd = it->oldEnd;
+      hunks.back().newEnd = it->newEnd;
+    } else {
+      hunks.push_back(*it);
+    }
+  }
+
+  return true;
+}
+
+ret_t ScintillaAWTK::UpdateText(const char* text, Sci::Position length) {
+  std::vector<DiffLine> a;
+  std::vector<DiffLine> b;
+  std::vector<DiffHunk> hunks;
+  Sci::Line a0 = 0;
+  Sci::Line b0 = 0;
+  Sci::Line a1 = 0;
+  Sci::Line b1 = 0;
+  return_value_if_fail(text != NULL && !pdoc->IsReadOnly(), RET_BAD_PARAMS);
+
+  DiffSplitDocument(pdoc, a);
+  DiffSplitText(text, length, b);
+
+  /*先去掉相同的开头和结尾，生成的代码通常只有中间一小段变化。*/
+  a1 = a.size();
+  b1 = b.size();
+  while (a0 < a1 && b0 < b1 && DiffLineEquals(pdoc, a[a0], text, b[b0])) {
+    a0++;
+    b0++;
+  }
+  while (a1 > a0 && b1 > b0 && DiffLineEquals(pdoc, a[a1 - 1], text, b[b1 - 1])) {
+    a1--;
+    b1--;
+  }
+
+  if (a0 == a1 && b0 == b1) {
+    return RET_OK;
+  }
+
+  if (!DiffMyers(pdoc, a, a0, a1, text, b, b0, b1, hunks)) {
+    DiffHunk hunk = {a0, a1, b0, b1};
+    hunks.clear();
+    hunks.push_back(hunk);
+  }
+
+  /*从后往前修改，前面的行的位置不受影响。光标和选择随修改自动调整，视图保持不动。*/
+  this->BeginBatch();
+  for (auto it = hunks.rbegin(); it != hunks.rend(); ++it) {
+    const Sci::Position pos = a[it->oldStart].start;
+    const Sci::Position end =
+        it->oldEnd > it->oldStart ? a[it->oldEnd - 1].start + a[it->oldEnd - 1].length : pos;
+    const Sci::Position from = it->newEnd > it->newStart ? b[it->newStart].start : 0;
+    const Sci::Position to =
+        it->newEnd > it->newStart ? b[it->newEnd - 1].start + b[it->newEnd - 1].length : 0;
+
+    if (end > pos) {
+      pdoc->DeleteChars(pos, end - pos);
+    }
+    if (to > from) {
+      pdoc->InsertString(pos, text + from, to - from);
+    }
+  }
+  this->EndBatch();
+
+  return RET_OK;
+}
+
+ret_t ScintillaAWTK::OnRepaintIdle(const idle_info_t* info) {
+  ScintillaAWTK* sciThis = (ScintillaAWTK*)(info->ctx);
+
+  sciThis->repaint_idle_id = TK_INVALID_ID;
+  if (sciThis->damage.w > 0 && sciThis->damage.h > 0) {
+    widget_invalidate_force(sciThis->widget, &(sciThis->damage));
+  } else {
+    widget_invalidate_force(sciThis->widget, NULL);
+  }
+
+  return RET_REMOVE;
+}
+
+void ScintillaAWTK::ScheduleRepaint(void) {
+  /*绘制过程中产生的脏区要放到下一帧处理。*/
+  if (this->repaint_idle_id == TK_INVALID_ID) {
+    this->repaint_idle_id = idle_add(OnRepaintIdle, this);
+  }
+}
+
+void ScintillaAWTK::GetDamage(rect_t* r, bool reset) {
+  *r = this->damage;
+  if (reset) {
+    this->damage = rect_init(0, 0, 0, 0);
+    this->invalidated = rect_init(0, 0, 0, 0);
+  }
+}
+
+void ScintillaAWTK::AddDamage(PRectangle rc) {
+  xy_t left = std::floor(rc.left);
+  xy_t top = std::floor(rc.top);
+  rect_t r = rect_init(left, top, std::ceil(rc.right) - left, std::ceil(rc.bottom) - top);
+
+  if (r.w <= 0 || r.h <= 0) {
+    return;
+  }
+
+  /*客户区坐标即控件坐标，合并后只让AWTK重绘这部分区域。*/
+  rect_merge(&(this->damage), &r);
+  if (paintState == notPainting) {
+    /*样式分析时每行的状态变化都会请求重绘整个窗口，已经提交过的区域不再重复提交。*/
+    if (r.x >= this->invalidated.x && r.y >= this->invalidated.y &&
+        r.x + r.w <= this->invalidated.x + this->invalidated.w &&
+        r.y + r.h <= this->invalidated.y + this->invalidated.h) {
+      return;
+    }
+    this->invalidated = r;
+    widget_invalidate_force(this->widget, &r);
+  } else {
+    this->ScheduleRepaint();
+  }
+}
+
+void ScintillaAWTK::RedrawRect(PRectangle rc) {
+  const PRectangle rcClient = GetClientRectangle();
+
+  if (this->batch_depth > 0) {
+    this->batch_redraw = true;
+    return;
+  }
+
+  this->redraw_requests++;
+  if (rc.top < rcClient.top) rc.top = rcClient.top;
+  if (rc.bottom > rcClient.bottom) rc.bottom = rcClient.bottom;
+  if (rc.left < rcClient.left) rc.left = rcClient.left;
+  if (rc.right > rcClient.right) rc.right = rcClient.right;
+
+  if ((rc.bottom > rc.top) && (rc.right > rc.left)) {
+    this->AddDamage(rc);
+  }
+}
+
+void ScintillaAWTK::Redraw() {
+  if (this->batch_depth > 0) {
+    this->batch_redraw = true;
+    return;
+  }
+
+  this->redraw_requests++;
+  this->AddDamage(GetClientRectangle());
 }
 
 void ScintillaAWTK::Invalidate(void) {
@@ -237,8 +1766,18 @@ void ScintillaAWTK::FineTickerCancel(TickReason reason) {
 
 ret_t ScintillaAWTK::OnIdle(const idle_info_t* info) {
   ScintillaAWTK* sciThis = (ScintillaAWTK*)(info->ctx);
+  Document* pdoc = sciThis->pdoc;
+  const double styling_duration = pdoc->durationStyling;
+  const Sci::Line styling_lines = pdoc->linesStyled;
+  const bool more = sciThis->Idle();
 
-  sciThis->Idle();
+  sciThis->NotifyStyling(pdoc->durationStyling - styling_duration,
+                         pdoc->linesStyled - styling_lines, true);
+
+  /*空闲样式分析每次只分析预算内的行，没有完成时在下一次idle中继续。*/
+  if (more && sciThis->idle_id != TK_INVALID_ID) {
+    return RET_REPEAT;
+  }
   sciThis->idle_id = TK_INVALID_ID;
 
   return RET_REMOVE;
@@ -246,7 +1785,9 @@ ret_t ScintillaAWTK::OnIdle(const idle_info_t* info) {
 
 bool ScintillaAWTK::SetIdle(bool on) {
   if (on) {
-    this->idle_id = idle_add(OnIdle, this);
+    if (this->idle_id == TK_INVALID_ID) {
+      this->idle_id = idle_add(OnIdle, this);
+    }
   } else {
     if (this->idle_id != TK_INVALID_ID) {
       idle_remove(this->idle_id);
@@ -417,7 +1958,11 @@ ret_t ScintillaAWTK::InsertString(const char* str, Sci::Position position) {
   int lengthInserted = pdoc->InsertString(position, str, strlen(str));
 
   if (lengthInserted > 0) {
-    this->MovePositionTo(position + lengthInserted);
+    if (this->batch_depth > 0) {
+      this->batch_caret = position + lengthInserted;
+    } else {
+      this->MovePositionTo(position + lengthInserted);
+    }
   }
 
   return RET_STOP;
@@ -437,11 +1982,67 @@ void ScintillaAWTK::SetHorizontalScrollPos() {
 void ScintillaAWTK::ClaimSelection() {
 }
 
+void ScintillaAWTK::BeginBatch(void) {
+  if (this->batch_depth++ == 0) {
+    this->batch_changed = false;
+    this->batch_redraw = false;
+    this->batch_scroll_bars = false;
+    this->batch_caret = INVALID_POSITION;
+    pdoc->BeginUndoAction();
+  }
+}
+
+void ScintillaAWTK::EndBatch(void) {
+  if (this->batch_depth == 0 || --this->batch_depth > 0) {
+    return;
+  }
+
+  /*批量修改期间推迟的光标移动、滚动条、重绘和变化通知在这里各做一次。*/
+  pdoc->EndUndoAction();
+  if (this->batch_caret != INVALID_POSITION) {
+    this->MovePositionTo(this->batch_caret);
+  }
+  if (this->batch_scroll_bars) {
+    this->SetScrollBars();
+  }
+  if (this->batch_redraw) {
+    this->Redraw();
+  }
+  if (this->batch_changed) {
+    this->NotifyChange();
+  }
+}
+
 void ScintillaAWTK::NotifyChange() {
+  if (this->batch_depth > 0) {
+    this->batch_changed = true;
+    return;
+  }
+
   widget_dispatch_simple_event(this->widget, EVT_VALUE_CHANGED);
 }
 
+void ScintillaAWTK::NotifyTextChanged(Sci::Position position, Sci::Position deleted,
+                                      const char* inserted, Sci::Position insertedLength) {
+  /*0保留给"没有快照"，回绕时跳过。*/
+  if (++this->generation == 0) {
+    this->generation = 1;
+  }
+
+  if (this->listener) {
+    this->listener->OnTextChanged(position, deleted, inserted, insertedLength);
+  }
+}
+
 void ScintillaAWTK::NotifyParent(SCNotification scn) {
+  if (scn.nmhdr.code == SCN_MODIFIED) {
+    /*插入和删除是分开通知的，插入时text指向文档中刚插入的内容。*/
+    if (scn.modificationType & SC_MOD_INSERTTEXT) {
+      NotifyTextChanged(scn.position, 0, scn.text, scn.length);
+    } else if (scn.modificationType & SC_MOD_DELETETEXT) {
+      NotifyTextChanged(scn.position, scn.length, NULL, 0);
+    }
+  }
 }
 
 bool ScintillaAWTK::HaveMouseCapture() {
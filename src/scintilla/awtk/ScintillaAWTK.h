@@ -1,10 +1,26 @@
 #include "ScintillaBase.h"
+#include "PlatAWTK.h"
 
 #ifndef SCINTILLA_AWTK_H
 #define SCINTILLA_AWTK_H
 
 namespace Scintilla {
 
+class LexJob;
+
+/*ScintillaAWTK向上层控件报告的通知，由控件实现并转换为自己的事件，ScintillaAWTK不依赖控件的头文件。*/
+class ScintillaAWTKListener {
+ public:
+  virtual ~ScintillaAWTKListener() {
+  }
+  /*插入或删除了文本，替换整个文档时deleted和insertedLength均为-1。*/
+  virtual void OnTextChanged(Sci::Position position, Sci::Position deleted, const char* inserted,
+                             Sci::Position insertedLength) = 0;
+  /*一帧的绘制或一次空闲处理中做了样式分析。*/
+  virtual void OnStyling(double duration, Sci::Line lines, Sci::Position endStyled,
+                         Sci::Position length, bool idle) = 0;
+};
+
 class ScintillaAWTK : public ScintillaBase {
  public:
   ScintillaAWTK(WindowID wid);
@@ -12,6 +28,24 @@ class ScintillaAWTK : public ScintillaBase {
 
   void OnPaint(widget_t* widget, canvas_t* c);
   void Invalidate(void);
+  uint32_t GetSkippedFrames(void) const;
+  uint32_t GetRedrawRequests(void) const;
+  uint32_t GetGeneration(void) const;
+  void SetListener(ScintillaAWTKListener* listener);
+  void SetBackgroundLexing(bool on);
+  bool IsBackgroundLexing(void) const;
+  void RequestBackgroundLexing(void);
+  void SetLexThreads(uint32_t threads);
+  uint32_t GetLexChunks(void) const;
+  void SetStylingBudget(uint32_t us);
+  void GetDamage(rect_t* r, bool reset);
+  uint32_t GetLinesLaidOut(void) const;
+  void SetMonospaceLayout(bool on);
+  uint32_t GetMonospaceRuns(void) const;
+  Sci::Position IndexMappedText(Sci::Position bytes);
+  const SurfaceStats& GetFrameStats(void) const;
+  static ILoader* CreateLoader(Sci::Position bytes, int options);
+  static ILoader* CreateMappedLoader(const char* filename);
 
   virtual void CreateCallTipWindow(PRectangle rc) override;
   virtual void AddToPopUp(const char* label, int cmd = 0, bool enabled = true) override;
@@ -35,6 +69,8 @@ class ScintillaAWTK : public ScintillaBase {
   virtual void FineTickerStart(TickReason reason, int millis, int tolerance) override;
   virtual void FineTickerCancel(TickReason reason) override;
   virtual bool SetIdle(bool) override;
+  virtual void RedrawRect(PRectangle rc) override;
+  virtual void Redraw() override;
 
  public:
   void AddText(const char* str);
@@ -48,6 +84,12 @@ class ScintillaAWTK : public ScintillaBase {
   ret_t OnKeyUp(key_event_t* e);
   ret_t InsertString(const char* str);
   ret_t InsertString(const char* str, Sci::Position position);
+  ret_t UpdateText(const char* text, Sci::Position length);
+  void BeginBatch(void);
+  void EndBatch(void);
+  void NotifyTextChanged(Sci::Position position, Sci::Position deleted, const char* inserted,
+                         Sci::Position insertedLength);
+  void AttachDocument(void* doc);
 
  private:
   struct TimeThunk {
@@ -61,11 +103,45 @@ class ScintillaAWTK : public ScintillaBase {
   Point last_point;
   PRectangle client;
   uint32_t idle_id;
+  uint32_t repaint_idle_id;
+  uint32_t skipped_frames;
+  uint32_t redraw_requests;
+  uint32_t frame_id;
+  bool painted;
+  uint32_t generation;
+  uint32_t batch_depth;
+  bool batch_changed;
+  bool batch_redraw;
+  bool batch_scroll_bars;
+  Sci::Position batch_caret;
+  SurfaceStats frame_stats;
+  rect_t damage;
+  rect_t invalidated;
+  std::unique_ptr<Surface> surface;
   TimeThunk timers[tickDwell + 1];
   bool lastKeyDownConsumed;
   widget_t* widget;
+  std::unique_ptr<ScintillaAWTKListener> listener;
   bool_t bar_to_edit;
+  void AddDamage(PRectangle rc);
+  void ScheduleRepaint(void);
   static ret_t OnIdle(const idle_info_t* info);
+  static ret_t OnRepaintIdle(const idle_info_t* info);
+  static ret_t OnFramePainted(void* ctx, event_t* e);
+  void NotifyStyling(double duration, Sci::Line lines, bool idle);
+  bool background_lexing;
+  bool lex_requested;
+  uint32_t lex_idle_id;
+  LexJob* lex_job;
+  uint32_t lex_threads;
+  uint32_t lex_chunks;
+  std::map<std::string, std::string> lex_properties;
+  std::vector<std::string> lex_keywords;
+  void StartLexJob(void);
+  bool CopyLexJob(LexJob* job);
+  void CancelLexJob(void);
+  bool MergeLexJob(LexJob* job);
+  static ret_t OnLexIdle(const idle_info_t* info);
   static ret_t OnTimeout(const timer_info_t* info);
 };
 };  // namespace Scintilla
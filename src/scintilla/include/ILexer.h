@@ -52,6 +52,12 @@ class IDocumentWithLineEnd : public IDocument {
 
 enum { lvOriginal = 0, lvSubStyles = 1, lvMetaData = 2, lvIdentity = 3 };
 
+// PrivateCall operation answered with non-null by lexers whose lexing after a line depends only on
+// the style, line state and fold level of that line, so restyling after a modification may stop
+// once these match the values from before. State held inside the lexer is rebuilt by lexing on
+// from where the previous pass stopped.
+enum { lpcConvergent = 0x43565247 };
+
 class ILexer {
  public:
   virtual int SCI_METHOD Version() const = 0;
@@ -230,14 +230,39 @@ constexpr bool IsStreamCommentStyle(int style) noexcept {
 		style == SCE_C_COMMENTDOCKEYWORDERROR;
 }
 
+// FNV-1a, used to fold the state carried from one line to the next into a line state
+constexpr unsigned int hashStart = 2166136261U;
+
+unsigned int HashBytes(unsigned int h, const char *s, size_t len) noexcept {
+	for (size_t i = 0; i < len; i++) {
+		h = (h ^ static_cast<unsigned char>(s[i])) * 16777619U;
+	}
+	return h;
+}
+
+unsigned int HashInt(unsigned int h, int value) noexcept {
+	return HashBytes(h, reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+unsigned int HashString(unsigned int h, const std::string &s) noexcept {
+	// Include the terminating NUL to separate consecutive strings
+	return HashBytes(h, s.c_str(), s.length() + 1);
+}
+
 struct PPDefinition {
 	Sci_Position line;
 	std::string key;
 	std::string value;
 	bool isUndef;
 	std::string arguments;
+	// Hash of this and all earlier definitions, not including the line so it survives lines being inserted
+	unsigned int hash;
 	PPDefinition(Sci_Position line_, const std::string &key_, const std::string &value_, bool isUndef_ = false, const std::string &arguments_="") :
-		line(line_), key(key_), value(value_), isUndef(isUndef_), arguments(arguments_) {
+		line(line_), key(key_), value(value_), isUndef(isUndef_), arguments(arguments_), hash(0) {
+	}
+	unsigned int Chain(unsigned int h) noexcept {
+		hash = HashString(HashString(HashString(HashInt(h ^ hashStart, isUndef), key), value), arguments);
+		return hash;
 	}
 };
 
@@ -270,6 +295,12 @@ class LinePPState {
 public:
 	LinePPState() noexcept {
 	}
+	bool IsDefault() const noexcept {
+		return (state == 0) && (ifTaken == 0) && (level == -1);
+	}
+	unsigned int Hash(unsigned int h) const noexcept {
+		return HashInt(HashInt(HashInt(h, state), ifTaken), level);
+	}
 	bool IsActive() const noexcept {
 		return state == 0;
 	}
@@ -309,6 +340,16 @@ public:
 	}
 };
 
+// The state carried from the end of a line into the next, stored as the line state so that
+// restyling after a modification can tell when it converges with the previous pass.
+// The common state outside any conditional, raw string or definition is 0.
+int LineStateFor(const LinePPState &preproc, const std::string &rawStringTerminator, unsigned int definitionsHash) noexcept {
+	if (preproc.IsDefault() && rawStringTerminator.empty() && (definitionsHash == 0))
+		return 0;
+	const unsigned int h = HashString(preproc.Hash(HashInt(hashStart, definitionsHash)), rawStringTerminator);
+	return static_cast<int>(h ? h : 1);
+}
+
 // Hold the preprocessor state for each line seen.
 // Currently one entry per line but could become sparse with just one entry per preprocessor line.
 class PPStates {
@@ -579,8 +620,9 @@ public:
 	void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess) override;
 	void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess) override;
 
-	void * SCI_METHOD PrivateCall(int, void *) noexcept override {
-		return nullptr;
+	void * SCI_METHOD PrivateCall(int operation, void *) noexcept override {
+		// Preprocessor and raw string state is mirrored into line states, see LineStateFor
+		return (operation == lpcConvergent) ? this : nullptr;
 	}
 
 	int SCI_METHOD LineEndTypesSupported() noexcept override {
@@ -838,16 +880,24 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 	}
 
 	SymbolTable preprocessorDefinitions = preprocessorDefinitionsStart;
+	unsigned int definitionsHash = 0;
 	for (const PPDefinition &ppDef : ppDefineHistory) {
 		if (ppDef.isUndef)
 			preprocessorDefinitions.erase(ppDef.key);
 		else
 			preprocessorDefinitions[ppDef.key] = SymbolValue(ppDef.value, ppDef.arguments);
+		definitionsHash = ppDef.hash;
 	}
 
 	std::string rawStringTerminator = rawStringTerminators.ValueAt(lineCurrent-1);
 	SparseState<std::string> rawSTNew(lineCurrent);
 
+	auto setLineState = [&](Sci_Position line) {
+		const int lineState = LineStateFor(preproc, rawStringTerminator, definitionsHash);
+		if (styler.GetLineState(line) != lineState)
+			styler.SetLineState(line, lineState);
+	};
+
 	int activitySet = preproc.ActiveState();
 
 	const WordClassifier &classifierIdentifiers = subStyles.Classifier(SCE_C_IDENTIFIER);
@@ -884,6 +934,7 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 			lineCurrent++;
 			lineEndNext = styler.LineEnd(lineCurrent);
 			vlls.Add(lineCurrent, preproc);
+			setLineState(lineCurrent-1);
 			if (rawStringTerminator != "") {
 				rawSTNew.Set(lineCurrent-1, rawStringTerminator);
 			}
@@ -895,6 +946,7 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 				lineCurrent++;
 				lineEndNext = styler.LineEnd(lineCurrent);
 				vlls.Add(lineCurrent, preproc);
+				setLineState(lineCurrent-1);
 				if (rawStringTerminator != "") {
 					rawSTNew.Set(lineCurrent-1, rawStringTerminator);
 				}
@@ -1213,6 +1265,7 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 			lineCurrent++;
 			lineEndNext = styler.LineEnd(lineCurrent);
 			vlls.Add(lineCurrent, preproc);
+			setLineState(lineCurrent-1);
 		}
 
 		// Determine if a new state should be entered.
@@ -1381,6 +1434,7 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 										value = restOfLine.substr(startValue);
 									preprocessorDefinitions[key] = SymbolValue(value, args);
 									ppDefineHistory.push_back(PPDefinition(lineCurrent, key, value, false, args));
+									definitionsHash = ppDefineHistory.back().Chain(definitionsHash);
 									definitionsChanged = true;
 								} else {
 									// Value
@@ -1392,6 +1446,7 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 										value = "1";	// No value defaults to 1
 									preprocessorDefinitions[key] = value;
 									ppDefineHistory.push_back(PPDefinition(lineCurrent, key, value));
+									definitionsHash = ppDefineHistory.back().Chain(definitionsHash);
 									definitionsChanged = true;
 								}
 							}
@@ -1403,6 +1458,7 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 									const std::string key = tokens[0];
 									preprocessorDefinitions.erase(key);
 									ppDefineHistory.push_back(PPDefinition(lineCurrent, key, "", true));
+									definitionsHash = ppDefineHistory.back().Chain(definitionsHash);
 									definitionsChanged = true;
 								}
 							}
@@ -253,8 +253,9 @@ class LexerJSON : public DefaultLexer {
 		}
 		return firstModification;
 	}
-	void *SCI_METHOD PrivateCall(int, void *) override {
-		return 0;
+	void *SCI_METHOD PrivateCall(int operation, void *) override {
+		// All state carried between lines is in the styles
+		return (operation == lpcConvergent) ? this : 0;
 	}
 	static ILexer *LexerFactoryJSON() {
 		return new LexerJSON;
@@ -146,6 +146,9 @@ static void ColouriseMaximaDoc(Sci_PositionU startPos, Sci_Position length, int
 		  break;
 	      }
 	  }
+	// A trailing backslash skips past the end of the range.
+	if(i >= lengthDoc)
+	  i = lengthDoc - 1;
 	styler.ColourTo(i, SCE_MAXIMA_STRING);
 	continue;
       }
@@ -179,6 +182,8 @@ static void ColouriseMaximaDoc(Sci_PositionU startPos, Sci_Position length, int
 	    if(cmdidx < 99)
 	      cmd[cmdidx++] = ch;
 	  }
+	if(i >= lengthDoc)
+	  i = lengthDoc - 1;
 
 	// A few known keywords
 	if(
@@ -349,6 +349,13 @@ static void ColouriseModulaDoc(	Sci_PositionU startPos,
 		case SCE_MODULA_DEFAULT:
 			if( ! skipWhiteSpaces( sc ) ) break;
 
+			// Non-ASCII characters can't start any token; the identifier
+			// scan below would otherwise match nothing and never advance.
+			if( ! IsASCII( sc.ch ) ) {
+				sc.Forward();
+				continue;
+			}
+
 			if( sc.ch == '(' && sc.chNext == '*' ) {
 				if( sc.GetRelative(2) == '*' ) {
 					sc.SetState( SCE_MODULA_DOXYCOMM );
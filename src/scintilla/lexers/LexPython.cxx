@@ -6,6 +6,7 @@
 // The License.txt file describes the conditions under which this software may be distributed.
 
 #include <cstdlib>
+#include <climits>
 #include <cassert>
 #include <cstring>
 
@@ -13,6 +14,7 @@
 #include <vector>
 #include <map>
 #include <algorithm>
+#include <atomic>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -123,6 +125,26 @@ void PushStateToStack(int state, std::vector<SingleFStringExpState> &stack, Sing
 	currentFStringExp = &stack.back();
 }
 
+// The f-string stack encoded exactly in a line state: the depth in bits 24-25 and up to 3
+// entries of 8 bits each holding the f-string state and a nesting count below 64. Other
+// stacks take a line state never used before so they are never taken as unchanged.
+int FStringStackLineState(const std::vector<SingleFStringExpState> &stack) noexcept {
+	static std::atomic<int> unique(0);
+	int lineState = static_cast<int>(stack.size()) << 24;
+
+	if (stack.size() > 3)
+		return INT_MIN | (++unique & INT_MAX);
+	for (size_t i = 0; i < stack.size(); i++) {
+		const int state = stack[i].state - SCE_P_FSTRING;
+		const int nesting = stack[i].nestingCount;
+		if (state < 0 || state > 3 || nesting < 0 || nesting > 63)
+			return INT_MIN | (++unique & INT_MAX);
+		lineState |= ((state << 6) | nesting) << (i * 8);
+	}
+
+	return lineState;
+}
+
 int PopFromStateStack(std::vector<SingleFStringExpState> &stack, SingleFStringExpState *&currentFStringExp) noexcept {
 	int state = 0;
 
@@ -372,8 +394,9 @@ public:
 	void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess) override;
 	void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess) override;
 
-	void *SCI_METHOD PrivateCall(int, void *) override {
-		return nullptr;
+	void *SCI_METHOD PrivateCall(int operation, void *) override {
+		// The f-string stack is encoded exactly in line states, see FStringStackLineState
+		return (operation == lpcConvergent) ? this : nullptr;
 	}
 
 	int SCI_METHOD LineEndTypesSupported() override {
@@ -414,7 +437,7 @@ public:
 	}
 
 private:
-	void ProcessLineEnd(StyleContext &sc, std::vector<SingleFStringExpState> &fstringStateStack, SingleFStringExpState *&currentFStringExp, bool &inContinuedString);
+	void ProcessLineEnd(StyleContext &sc, LexAccessor &styler, std::vector<SingleFStringExpState> &fstringStateStack, SingleFStringExpState *&currentFStringExp, bool &inContinuedString);
 };
 
 Sci_Position SCI_METHOD LexerPython::PropertySet(const char *key, const char *val) {
@@ -446,7 +469,7 @@ Sci_Position SCI_METHOD LexerPython::WordListSet(int n, const char *wl) {
 	return firstModification;
 }
 
-void LexerPython::ProcessLineEnd(StyleContext &sc, std::vector<SingleFStringExpState> &fstringStateStack, SingleFStringExpState *&currentFStringExp, bool &inContinuedString) {
+void LexerPython::ProcessLineEnd(StyleContext &sc, LexAccessor &styler, std::vector<SingleFStringExpState> &fstringStateStack, SingleFStringExpState *&currentFStringExp, bool &inContinuedString) {
 	long deepestSingleStateIndex = -1;
 	unsigned long i;
 
@@ -472,6 +495,12 @@ void LexerPython::ProcessLineEnd(StyleContext &sc, std::vector<SingleFStringExpS
 		ftripleStateAtEol.insert(val);
 	}
 
+	// Mirror the f-string stack into the line state so restyling can tell when it converges
+	const int lineState = FStringStackLineState(fstringStateStack);
+	if (styler.GetLineState(sc.currentLine) != lineState) {
+		styler.SetLineState(sc.currentLine, lineState);
+	}
+
 	if ((sc.state == SCE_P_DEFAULT)
 			|| IsPyTripleQuoteStringState(sc.state)) {
 		// Perform colourisation of white space and triple quoted strings at end of each line to allow
@@ -573,7 +602,7 @@ void SCI_METHOD LexerPython::Lex(Sci_PositionU startPos, Sci_Position length, in
 		}
 
 		if (sc.atLineEnd) {
-			ProcessLineEnd(sc, fstringStateStack, currentFStringExp, inContinuedString);
+			ProcessLineEnd(sc, styler, fstringStateStack, currentFStringExp, inContinuedString);
 			lineCurrent++;
 			if (!sc.More())
 				break;
@@ -759,7 +788,7 @@ void SCI_METHOD LexerPython::Lex(Sci_PositionU startPos, Sci_Position length, in
 
 		// State exit code may have moved on to end of line
 		if (needEOLCheck && sc.atLineEnd) {
-			ProcessLineEnd(sc, fstringStateStack, currentFStringExp, inContinuedString);
+			ProcessLineEnd(sc, styler, fstringStateStack, currentFStringExp, inContinuedString);
 			lineCurrent++;
 			styler.IndentAmount(lineCurrent, &spaceFlags, IsPyComment);
 			if (!sc.More())
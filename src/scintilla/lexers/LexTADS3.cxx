@@ -98,12 +98,14 @@ static inline bool IsATADS3Operator(const int ch) {
                 || ch == '@' || ch == '&' || ch == '~';
 }
 
+// ctype functions are only defined for ASCII here; a non-ASCII character
+// accepted as a word start but not as a word char would never be consumed.
 static inline bool IsAWordChar(const int ch) {
-        return isalnum(ch) || ch == '_';
+        return IsASCII(ch) && (isalnum(ch) || ch == '_');
 }
 
 static inline bool IsAWordStart(const int ch) {
-        return isalpha(ch) || ch == '_';
+        return IsASCII(ch) && (isalpha(ch) || ch == '_');
 }
 
 static inline bool IsAHexDigit(const int ch) {
@@ -52,6 +52,24 @@ void SCI_METHOD LexerSimple::Fold(Sci_PositionU startPos, Sci_Position lengthDoc
 	}
 }
 
+void * SCI_METHOD LexerSimple::PrivateCall(int operation, void *) {
+	// Only lexers checked to colour each line from its own text and carry nothing else into
+	// the next line but the style, line state and fold level at its end. Others look further
+	// back, such as Ruby here documents which search for the delimiter on an earlier line.
+	if (operation == lpcConvergent) {
+		switch (module->GetLanguage()) {
+		case SCLEX_PROPERTIES:
+		case SCLEX_DIFF:
+		case SCLEX_MAKEFILE:
+		case SCLEX_ERRORLIST:
+			return this;
+		default:
+			break;
+		}
+	}
+	return nullptr;
+}
+
 const char * SCI_METHOD LexerSimple::GetName() {
 	return module->languageName;
 }
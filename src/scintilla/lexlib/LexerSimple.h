@@ -22,6 +22,7 @@ class LexerSimple : public LexerBase {
                       IDocument* pAccess) override;
   void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle,
                        IDocument* pAccess) override;
+  void* SCI_METHOD PrivateCall(int operation, void* pointer) override;
   // ILexerWithIdentity methods
   const char* SCI_METHOD GetName() override;
   int SCI_METHOD GetIdentifier() override;
@@ -42,6 +42,14 @@ void Catalogue::AddLexerModule(LexerModule *plm) {
 	catalogueDefault.AddLexerModule(plm);
 }
 
+unsigned int Catalogue::Count() {
+	return catalogueDefault.Count();
+}
+
+const char *Catalogue::Name(unsigned int index) {
+	return catalogueDefault.Name(index);
+}
+
 // To add or remove a lexer, add or remove its file and run LexGen.py.
 
 // Force a reference to all of the Scintilla lexers so that the linker will
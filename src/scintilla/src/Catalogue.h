@@ -17,6 +17,8 @@ class Catalogue {
   static const LexerModule* Find(int language);
   static const LexerModule* Find(const char* languageName);
   static void AddLexerModule(LexerModule* plm);
+  static unsigned int Count();
+  static const char* Name(unsigned int index);
 };
 
 }  // namespace Scintilla
@@ -537,6 +537,9 @@ CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_) :
 	utf8Substance = false;
 	utf8LineEnds = 0;
 	collectingUndo = true;
+	externalData = nullptr;
+	externalLength = 0;
+	externalIndexed = 0;
 	if (largeDocument)
 		plv = Sci::make_unique<LineVector<Sci::Position>>();
 	else
@@ -547,11 +550,11 @@ CellBuffer::~CellBuffer() {
 }
 
 char CellBuffer::CharAt(Sci::Position position) const noexcept {
-	return substance.ValueAt(position);
+	return ValueAt(position);
 }
 
 unsigned char CellBuffer::UCharAt(Sci::Position position) const noexcept {
-	return substance.ValueAt(position);
+	return ValueAt(position);
 }
 
 void CellBuffer::GetCharRange(char *buffer, Sci::Position position, Sci::Position lengthRetrieve) const {
@@ -559,11 +562,15 @@ void CellBuffer::GetCharRange(char *buffer, Sci::Position position, Sci::Positio
 		return;
 	if (position < 0)
 		return;
-	if ((position + lengthRetrieve) > substance.Length()) {
+	if ((position + lengthRetrieve) > Length()) {
 		Platform::DebugPrintf("Bad GetCharRange %.0f for %.0f of %.0f\n",
 				      static_cast<double>(position),
 				      static_cast<double>(lengthRetrieve),
-				      static_cast<double>(substance.Length()));
+				      static_cast<double>(Length()));
+		return;
+	}
+	if (externalData) {
+		memcpy(buffer, externalData + position, lengthRetrieve);
 		return;
 	}
 	substance.GetRange(buffer, position, lengthRetrieve);
@@ -593,14 +600,20 @@ void CellBuffer::GetStyleRange(unsigned char *buffer, Sci::Position position, Sc
 }
 
 const char *CellBuffer::BufferPointer() {
+	if (externalData)
+		return externalData;
 	return substance.BufferPointer();
 }
 
 const char *CellBuffer::RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept {
+	if (externalData)
+		return externalData + position;
 	return substance.RangePointer(position, rangeLength);
 }
 
 Sci::Position CellBuffer::GapPosition() const noexcept {
+	if (externalData)
+		return externalIndexed;
 	return substance.GapPosition();
 }
 
@@ -670,16 +683,68 @@ const char *CellBuffer::DeleteChars(Sci::Position position, Sci::Position delete
 }
 
 Sci::Position CellBuffer::Length() const noexcept {
+	// Only the indexed part of external text is visible so the last line never runs into unindexed text
+	if (externalData)
+		return externalIndexed;
 	return substance.Length();
 }
 
 void CellBuffer::Allocate(Sci::Position newSize) {
+	if (externalData)
+		return;
 	substance.ReAllocate(newSize);
 	if (hasStyles) {
 		style.ReAllocate(newSize);
 	}
 }
 
+void CellBuffer::SetExternalText(std::unique_ptr<IExternalText> text) {
+	PLATFORM_ASSERT(substance.Length() == 0);
+	PLATFORM_ASSERT(!hasStyles);
+	external = std::move(text);
+	externalData = external ? external->Data() : nullptr;
+	externalLength = external ? external->Length() : 0;
+	externalIndexed = 0;
+	// External text can not be changed so there is nothing to undo
+	readOnly = externalData != nullptr;
+	collectingUndo = false;
+	plv->Init();
+}
+
+Sci::Position CellBuffer::IndexExternalText(Sci::Position length) {
+	// Same line end rules as ResetLineEnds but may be performed in steps
+	if (!externalData)
+		return 0;
+	const Sci::Position end = std::min(externalIndexed + length, externalLength);
+	const bool atLineStart = true;
+	Sci::Line lineInsert = plv->Lines();
+	plv->InsertText(lineInsert - 1, end - externalIndexed);
+	unsigned char chBeforePrev = ValueAt(externalIndexed - 2);
+	unsigned char chPrev = ValueAt(externalIndexed - 1);
+	for (Sci::Position i = externalIndexed; i < end; i++) {
+		const unsigned char ch = externalData[i];
+		if (ch == '\r') {
+			if (ValueAt(i + 1) != '\n') {
+				InsertLine(lineInsert, i + 1, atLineStart);
+				lineInsert++;
+			}
+		} else if (ch == '\n') {
+			InsertLine(lineInsert, i + 1, atLineStart);
+			lineInsert++;
+		} else if (utf8LineEnds) {
+			const unsigned char back3[3] = {chBeforePrev, chPrev, ch};
+			if (UTF8IsSeparator(back3) || UTF8IsNEL(back3+1)) {
+				InsertLine(lineInsert, i + 1, atLineStart);
+				lineInsert++;
+			}
+		}
+		chBeforePrev = chPrev;
+		chPrev = ch;
+	}
+	externalIndexed = end;
+	return externalIndexed;
+}
+
 void CellBuffer::SetUTF8Substance(bool utf8Substance_) noexcept {
 	utf8Substance = utf8Substance_;
 }
@@ -763,7 +828,7 @@ bool CellBuffer::IsReadOnly() const noexcept {
 }
 
 void CellBuffer::SetReadOnly(bool set) noexcept {
-	readOnly = set;
+	readOnly = set || (externalData != nullptr);
 }
 
 bool CellBuffer::IsLarge() const noexcept {
@@ -810,10 +875,10 @@ void CellBuffer::RemoveLine(Sci::Line line) {
 
 bool CellBuffer::UTF8LineEndOverlaps(Sci::Position position) const noexcept {
 	const unsigned char bytes[] = {
-		static_cast<unsigned char>(substance.ValueAt(position-2)),
-		static_cast<unsigned char>(substance.ValueAt(position-1)),
-		static_cast<unsigned char>(substance.ValueAt(position)),
-		static_cast<unsigned char>(substance.ValueAt(position+1)),
+		static_cast<unsigned char>(ValueAt(position-2)),
+		static_cast<unsigned char>(ValueAt(position-1)),
+		static_cast<unsigned char>(ValueAt(position)),
+		static_cast<unsigned char>(ValueAt(position+1)),
 	};
 	return UTF8IsSeparator(bytes) || UTF8IsSeparator(bytes+1) || UTF8IsNEL(bytes+1);
 }
@@ -827,7 +892,7 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const {
 			if (posBack < 0) {
 				return false;
 			}
-			back.insert(0, 1, substance.ValueAt(posBack));
+			back.insert(0, 1, ValueAt(posBack));
 			if (!UTF8IsTrailByte(back.front())) {
 				if (i > 0) {
 					// Have reached a non-trail
@@ -841,7 +906,7 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const {
 		}
 	}
 	if (position < Length()) {
-		const unsigned char fore = substance.ValueAt(position);
+		const unsigned char fore = ValueAt(position);
 		if (UTF8IsTrailByte(fore)) {
 			return false;
 		}
@@ -861,7 +926,7 @@ void CellBuffer::ResetLineEnds() {
 	unsigned char chBeforePrev = 0;
 	unsigned char chPrev = 0;
 	for (Sci::Position i = 0; i < length; i++) {
-		const unsigned char ch = substance.ValueAt(position + i);
+		const unsigned char ch = ValueAt(position + i);
 		if (ch == '\r') {
 			InsertLine(lineInsert, (position + i) + 1, atLineStart);
 			lineInsert++;
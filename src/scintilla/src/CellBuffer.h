@@ -104,6 +104,18 @@ class UndoHistory {
   void CompletedRedoStep();
 };
 
+/**
+ * Read-only text owned outside the buffer, such as a memory mapped file.
+ * The text must stay valid and unchanged until the object is destroyed.
+ */
+class IExternalText {
+ public:
+  virtual ~IExternalText() {
+  }
+  virtual const char* Data() const noexcept = 0;
+  virtual Sci::Position Length() const noexcept = 0;
+};
+
 /**
  * Holder for an expandable array of characters that supports undo and line markers.
  * Based on article "Data Structures in a Bit-Mapped Text Editor"
@@ -124,6 +136,17 @@ class CellBuffer {
 
   std::unique_ptr<ILineVector> plv;
 
+  std::unique_ptr<IExternalText> external;
+  const char* externalData;
+  Sci::Position externalLength;
+  Sci::Position externalIndexed;
+
+  char ValueAt(Sci::Position position) const noexcept {
+    if (externalData) {
+      return (position >= 0 && position < externalLength) ? externalData[position] : '\0';
+    }
+    return substance.ValueAt(position);
+  }
   bool UTF8LineEndOverlaps(Sci::Position position) const noexcept;
   bool UTF8IsCharacterBoundary(Sci::Position position) const;
   void ResetLineEnds();
@@ -155,6 +178,12 @@ class CellBuffer {
 
   Sci::Position Length() const noexcept;
   void Allocate(Sci::Position newSize);
+  /// Use read-only external text instead of the gap buffer. Only valid on an empty buffer.
+  /// Lines are found incrementally by IndexExternalText and the length grows as they are found.
+  void SetExternalText(std::unique_ptr<IExternalText> text);
+  /// Find line ends in up to length more bytes of the external text.
+  /// @return the number of bytes indexed so far.
+  Sci::Position IndexExternalText(Sci::Position length);
   void SetUTF8Substance(bool utf8Substance_) noexcept;
   int GetLineEndTypes() const noexcept {
     return utf8LineEnds;
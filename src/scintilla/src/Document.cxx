@@ -58,6 +58,10 @@ void LexInterface::Colourise(Sci::Position start, Sci::Position end) {
 		const Sci::Position lengthDoc = pdoc->Length();
 		if (end == -1)
 			end = lengthDoc;
+		// The previous pass stopped early so state inside the lexer only reaches that far
+		if ((lexedTo >= 0) && (start > lexedTo))
+			start = lexedTo;
+		lexedTo = -1;
 		const Sci::Position len = end - start;
 
 		PLATFORM_ASSERT(len >= 0);
@@ -68,14 +72,85 @@ void LexInterface::Colourise(Sci::Position start, Sci::Position end) {
 			styleStart = pdoc->StyleAt(start - 1);
 
 		if (len > 0) {
-			instance->Lex(start, len, styleStart, pdoc);
-			instance->Fold(start, len, styleStart, pdoc);
+			if (convergent && (pdoc->StyleCheckpointEnd() >= end)) {
+				ColouriseToCheckpoint(start, end);
+			} else {
+				instance->Lex(start, len, styleStart, pdoc);
+				instance->Fold(start, len, styleStart, pdoc);
+				pdoc->linesStyled += pdoc->SciLineFromPosition(end - 1) - pdoc->SciLineFromPosition(start) + 1;
+			}
 		}
 
 		performingStyle = false;
 	}
 }
 
+// Lex in runs of lines that double in length and stop once the state at the end of a run matches
+// the checkpoint kept from before the modifications, reusing the rest of the checkpoint.
+void LexInterface::ColouriseToCheckpoint(Sci::Position start, Sci::Position end) {
+	Sci::Line line = pdoc->SciLineFromPosition(start);
+	Sci::Line lines = 1;
+	Sci::Position pos = start;
+	while (pos < end) {
+		const Sci::Line lineNext = line + lines;
+		const Sci::Position posNext = std::min(pdoc->LineStart(lineNext), end);
+		const Sci::Line lineCheck = lineNext - 1;
+		const bool check = (posNext == pdoc->LineStart(lineNext)) && pdoc->StyleCheckpointAt(lineCheck);
+		const char styleCheck = check ? pdoc->StyleAt(posNext - 1) : 0;
+		const int stateCheck = check ? pdoc->GetLineState(lineCheck) : 0;
+		const int levelCheck = check ? pdoc->GetLevel(lineCheck) : 0;
+		const int styleStart = (pos > 0) ? pdoc->StyleAt(pos - 1) : 0;
+
+		instance->Lex(pos, posNext - pos, styleStart, pdoc);
+		instance->Fold(pos, posNext - pos, styleStart, pdoc);
+		pdoc->linesStyled += pdoc->SciLineFromPosition(posNext - 1) - line + 1;
+
+		// The lexer may have reported a state change that invalidates the check
+		if (check && pdoc->StyleCheckpointAt(lineCheck) && (pdoc->StyleAt(posNext - 1) == styleCheck) &&
+			(pdoc->GetLineState(lineCheck) == stateCheck) && (pdoc->GetLevel(lineCheck) == levelCheck)) {
+			pdoc->StyleCheckpointReached();
+			lexedTo = posNext;
+			return;
+		}
+		pos = posNext;
+		line = lineNext;
+		lines = std::min<Sci::Line>(lines * 2, 0x10000);
+	}
+}
+
+// Styles from position on were set without running this instance, for example merged from a
+// background pass, so its internal state only reaches position.
+void LexInterface::InvalidateStateFrom(Sci::Position position) noexcept {
+	if ((lexedTo < 0) || (position < lexedTo))
+		lexedTo = position;
+}
+
+// Run the lexer over up to length bytes of the styled text it has not seen so that a later
+// modification does not have to catch up first. Returns whether there is more to catch up.
+bool LexInterface::CatchUp(Sci::Position length) {
+	if (!pdoc || !instance || performingStyle || (lexedTo < 0))
+		return false;
+	const Sci::Position endStyled = pdoc->GetEndStyled();
+	if (lexedTo >= endStyled) {
+		lexedTo = -1;
+		return false;
+	}
+	performingStyle = true;
+	const Sci::Position start = lexedTo;
+	Sci::Position end = std::min(start + length, endStyled);
+	if (end < endStyled)
+		end = std::min(pdoc->LineStart(pdoc->SciLineFromPosition(end) + 1), endStyled);
+	const int styleStart = (start > 0) ? pdoc->StyleAt(start - 1) : 0;
+	instance->Lex(start, end - start, styleStart, pdoc);
+	instance->Fold(start, end - start, styleStart, pdoc);
+	// Lexing moved the end of styling back to end but the rest is still styled
+	if (pdoc->GetEndStyled() < endStyled)
+		pdoc->StartStyling(endStyled, '\xff');
+	lexedTo = (end < endStyled) ? end : -1;
+	performingStyle = false;
+	return lexedTo >= 0;
+}
+
 int LexInterface::LineEndTypesSupported() {
 	if (instance) {
 		const int interfaceVersion = instance->Version();
@@ -121,7 +196,11 @@ Document::Document(int options) :
 	dbcsCodePage = SC_CP_UTF8;
 	lineEndBitSet = SC_LINE_END_TYPE_DEFAULT;
 	endStyled = 0;
+	checkpointStart = 0;
+	endCheckpoint = 0;
 	styleClock = 0;
+	durationStyling = 0.0;
+	linesStyled = 0;
 	enteredModification = 0;
 	enteredStyling = 0;
 	enteredReadOnlyCount = 0;
@@ -276,7 +355,8 @@ void Document::TentativeUndo() {
 				}
 				cb.PerformUndoStep();
 				if (action.at != containerAction) {
-					ModifiedAt(action.position);
+					TextModifiedAt(action.position, action.position,
+						(action.at == removeAction) ? action.lenData : -action.lenData);
 				}
 
 				int modFlags = SC_PERFORMED_UNDO;
@@ -1176,6 +1256,31 @@ EncodingFamily Document::CodePageFamily() const noexcept {
 void Document::ModifiedAt(Sci::Position pos) noexcept {
 	if (endStyled > pos)
 		endStyled = pos;
+	if (endCheckpoint > pos)
+		endCheckpoint = pos;
+}
+
+// Text was inserted (lengthChange > 0) or deleted (lengthChange < 0) at position and styling
+// must restart at pos. The styles after the modification are kept as a checkpoint.
+void Document::TextModifiedAt(Sci::Position pos, Sci::Position position, Sci::Position lengthChange) noexcept {
+	if (endStyled >= endCheckpoint) {
+		// Nothing pending so all the styled text becomes the checkpoint
+		checkpointStart = 0;
+		endCheckpoint = endStyled;
+	} else if (endStyled > checkpointStart) {
+		// Partially restyled text was not compared with the checkpoint so can not be trusted
+		checkpointStart = endStyled;
+	}
+	if (checkpointStart > position)
+		checkpointStart = std::max(position, checkpointStart + lengthChange);
+	if (endCheckpoint > position)
+		endCheckpoint = std::max(position, endCheckpoint + lengthChange);
+	// The line holding the end of the modification was split or joined, so its line state and
+	// fold level were copied from another line by PerLine rather than kept from before
+	const Sci::Line lineEnd = SciLineFromPosition(position + std::max<Sci::Position>(lengthChange, 0));
+	checkpointStart = std::max(checkpointStart, cb.LineStart(lineEnd + 1));
+	if (endStyled > pos)
+		endStyled = pos;
 }
 
 void Document::CheckReadOnly() {
@@ -1214,9 +1319,9 @@ bool Document::DeleteChars(Sci::Position pos, Sci::Position len) {
 			if (startSavePoint && cb.IsCollectingUndo())
 				NotifySavePoint(!startSavePoint);
 			if ((pos < LengthNoExcept()) || (pos == 0))
-				ModifiedAt(pos);
+				TextModifiedAt(pos, pos, -len);
 			else
-				ModifiedAt(pos-1);
+				TextModifiedAt(pos-1, pos, -len);
 			NotifyModified(
 			    DocModification(
 			        SC_MOD_DELETETEXT | SC_PERFORMED_USER | (startSequence?SC_STARTACTION:0),
@@ -1265,7 +1370,7 @@ Sci::Position Document::InsertString(Sci::Position position, const char *s, Sci:
 	const char *text = cb.InsertString(position, s, insertLength, startSequence);
 	if (startSavePoint && cb.IsCollectingUndo())
 		NotifySavePoint(!startSavePoint);
-	ModifiedAt(position);
+	TextModifiedAt(position, position, insertLength);
 	NotifyModified(
 		DocModification(
 			SC_MOD_INSERTTEXT | SC_PERFORMED_USER | (startSequence?SC_STARTACTION:0),
@@ -1335,7 +1440,8 @@ Sci::Position Document::Undo() {
 				}
 				cb.PerformUndoStep();
 				if (action.at != containerAction) {
-					ModifiedAt(action.position);
+					TextModifiedAt(action.position, action.position,
+						(action.at == removeAction) ? action.lenData : -action.lenData);
 					newPos = action.position;
 				}
 
@@ -1409,7 +1515,8 @@ Sci::Position Document::Redo() {
 				}
 				cb.PerformRedoStep();
 				if (action.at != containerAction) {
-					ModifiedAt(action.position);
+					TextModifiedAt(action.position, action.position,
+						(action.at == insertAction) ? action.lenData : -action.lenData);
 					newPos = action.position;
 				}
 
@@ -2243,27 +2350,51 @@ bool SCI_METHOD Document::SetStyles(Sci_Position length, const char *styles) {
 
 void Document::EnsureStyledTo(Sci::Position pos) {
 	if ((enteredStyling == 0) && (pos > GetEndStyled())) {
+		ElapsedPeriod epStyling;
 		IncrementStyleClock();
 		if (pli && !pli->UseContainerLexing()) {
 			const Sci::Line lineEndStyled = SciLineFromPosition(GetEndStyled());
 			const Sci::Position endStyledTo = LineStart(lineEndStyled);
+			// Counts the lines actually lexed into linesStyled
 			pli->Colourise(endStyledTo, pos);
 		} else {
+			const Sci::Line lineFirst = SciLineFromPosition(GetEndStyled());
 			// Ask the watchers to style, and stop as soon as one responds.
 			for (std::vector<WatcherWithUserData>::iterator it = watchers.begin();
 				(pos > GetEndStyled()) && (it != watchers.end()); ++it) {
 				it->watcher->NotifyStyleNeeded(this, it->userData, pos);
 			}
+			linesStyled += std::max<Sci::Line>(SciLineFromPosition(GetEndStyled()) - lineFirst, 0);
 		}
+		durationStyling += epStyling.Duration();
 	}
 }
 
+Sci::Position Document::StyleCheckpointEnd() const noexcept {
+	return (endCheckpoint > endStyled) ? endCheckpoint : 0;
+}
+
+// Whether the styles, line state and fold level of line are from the checkpoint, which also covers
+// everything after line.
+bool Document::StyleCheckpointAt(Sci::Line line) const noexcept {
+	return (endCheckpoint > endStyled) && (LineStart(line) >= checkpointStart) &&
+		(LineStart(line + 1) <= endCheckpoint);
+}
+
+// Lexing reproduced the checkpoint state so the rest of the checkpoint is valid.
+void Document::StyleCheckpointReached() noexcept {
+	if (endCheckpoint > endStyled)
+		endStyled = endCheckpoint;
+	checkpointStart = 0;
+	endCheckpoint = 0;
+}
+
 void Document::StyleToAdjustingLineDuration(Sci::Position pos) {
-	const Sci::Line lineFirst = SciLineFromPosition(GetEndStyled());
+	// Lines actually lexed as styling may stop early when it converges with the checkpoint
+	const Sci::Line linesFirst = linesStyled;
 	ElapsedPeriod epStyling;
 	EnsureStyledTo(pos);
-	const Sci::Line lineLast = SciLineFromPosition(GetEndStyled());
-	durationStyleOneLine.AddSample(lineLast - lineFirst, epStyling.Duration());
+	durationStyleOneLine.AddSample(linesStyled - linesFirst, epStyling.Duration());
 }
 
 void Document::LexerChanged() {
@@ -2300,6 +2431,9 @@ Sci::Line Document::GetMaxLineState() const noexcept {
 }
 
 void SCI_METHOD Document::ChangeLexerState(Sci_Position start, Sci_Position end) {
+	// The lexer state differs from before up to end so the checkpoint can not be matched there.
+	if (end > checkpointStart)
+		checkpointStart = std::min<Sci::Position>(end, endCheckpoint);
 	const DocModification mh(SC_MOD_LEXERSTATE, start,
 		end-start, 0, 0, 0);
 	NotifyModified(mh);
@@ -177,13 +177,18 @@ class LexInterface {
   Document* pdoc;
   ILexer* instance;
   bool performingStyle;  ///< Prevent reentrance
+  bool convergent;       ///< Lexer answers lpcConvergent
+  Sci::Position lexedTo; ///< Where the last pass stopped early, -1 when it did not
+  void ColouriseToCheckpoint(Sci::Position start, Sci::Position end);
  public:
   explicit LexInterface(Document* pdoc_) noexcept
-      : pdoc(pdoc_), instance(nullptr), performingStyle(false) {
+      : pdoc(pdoc_), instance(nullptr), performingStyle(false), convergent(false), lexedTo(-1) {
   }
   virtual ~LexInterface() {
   }
   void Colourise(Sci::Position start, Sci::Position end);
+  void InvalidateStateFrom(Sci::Position position) noexcept;
+  bool CatchUp(Sci::Position length);
   virtual int LineEndTypesSupported();
   bool UseContainerLexing() const noexcept {
     return instance == nullptr;
@@ -239,6 +244,10 @@ class Document : PerLine, public IDocumentWithLineEnd, public ILoader {
   CharacterCategoryMap charMap;
   std::unique_ptr<CaseFolder> pcf;
   Sci::Position endStyled;
+  // Styles in [checkpointStart, endCheckpoint) were produced before the pending text modifications
+  // for text that has not changed since, so restyling may stop once the lexer state converges.
+  Sci::Position checkpointStart;
+  Sci::Position endCheckpoint;
   int styleClock;
   int enteredModification;
   int enteredStyling;
@@ -286,6 +295,10 @@ class Document : PerLine, public IDocumentWithLineEnd, public ILoader {
   bool tabIndents;
   bool backspaceUnindents;
   ActionDuration durationStyleOneLine;
+  // Cumulative time spent in EnsureStyledTo and lines lexed so the platform layer can report
+  // the styling cost of each frame.
+  double durationStyling;
+  Sci::Line linesStyled;
 
   std::unique_ptr<IDecorationList> decorations;
 
@@ -354,6 +367,7 @@ class Document : PerLine, public IDocumentWithLineEnd, public ILoader {
 
   // Gateways to modifying document
   void ModifiedAt(Sci::Position pos) noexcept;
+  void TextModifiedAt(Sci::Position pos, Sci::Position position, Sci::Position lengthChange) noexcept;
   void CheckReadOnly();
   bool DeleteChars(Sci::Position pos, Sci::Position len);
   Sci::Position InsertString(Sci::Position position, const char* s, Sci::Position insertLength);
@@ -494,6 +508,12 @@ class Document : PerLine, public IDocumentWithLineEnd, public ILoader {
   void Allocate(Sci::Position newSize) {
     cb.Allocate(newSize);
   }
+  void SetExternalText(std::unique_ptr<IExternalText> text) {
+    cb.SetExternalText(std::move(text));
+  }
+  Sci::Position IndexExternalText(Sci::Position length) {
+    return cb.IndexExternalText(length);
+  }
 
   CharacterExtracted ExtractCharacter(Sci::Position position) const noexcept;
 
@@ -525,6 +545,9 @@ class Document : PerLine, public IDocumentWithLineEnd, public ILoader {
   }
   void EnsureStyledTo(Sci::Position pos);
   void StyleToAdjustingLineDuration(Sci::Position pos);
+  Sci::Position StyleCheckpointEnd() const noexcept;
+  bool StyleCheckpointAt(Sci::Line line) const noexcept;
+  void StyleCheckpointReached() noexcept;
   void LexerChanged();
   int GetStyleClock() const noexcept {
     return styleClock;
@@ -178,6 +178,7 @@ EditView::EditView() {
 	bufferedDraw = false;
 	phasesDraw = phasesTwo;
 	lineWidthMaxSeen = 0;
+	linesLaidOut = 0;
 	additionalCaretsBlink = true;
 	additionalCaretsVisible = true;
 	imeCaretBlockOverride = false;
@@ -459,7 +460,7 @@ void EditView::LayoutLine(const EditModel &model, Sci::Line line, Surface *surfa
 		ll->positions[0] = 0;
 		bool lastSegItalics = false;
 
-		BreakFinder bfLayout(ll, nullptr, Range(0, numCharsInLine), posLineStart, 0, false, model.pdoc, &model.reprs, nullptr);
+		BreakFinder bfLayout(ll, nullptr, Range(0, numCharsInLine), posLineStart, 0, false, model.pdoc, &model.reprs, nullptr, breakPositions);
 		while (bfLayout.More()) {
 
 			const TextSegment ts = bfLayout.Next();
@@ -1451,7 +1452,7 @@ static void DrawWrapIndentAndMarker(Surface *surface, const ViewStyle &vsDraw, c
 
 void EditView::DrawBackground(Surface *surface, const EditModel &model, const ViewStyle &vsDraw, const LineLayout *ll,
 	PRectangle rcLine, Range lineRange, Sci::Position posLineStart, int xStart,
-	int subLine, ColourOptional background) const {
+	int subLine, ColourOptional background) {
 
 	const bool selBackDrawn = vsDraw.SelectionBackgroundDrawn();
 	bool inIndentation = subLine == 0;	// Do not handle indentation except on first subline.
@@ -1459,7 +1460,7 @@ void EditView::DrawBackground(Surface *surface, const EditModel &model, const Vi
 	// Does not take margin into account but not significant
 	const int xStartVisible = static_cast<int>(subLineStart)-xStart;
 
-	BreakFinder bfBack(ll, &model.sel, lineRange, posLineStart, xStartVisible, selBackDrawn, model.pdoc, &model.reprs, nullptr);
+	BreakFinder bfBack(ll, &model.sel, lineRange, posLineStart, xStartVisible, selBackDrawn, model.pdoc, &model.reprs, nullptr, breakPositions);
 
 	const bool drawWhitespaceBackground = vsDraw.WhitespaceBackgroundDrawn() && !background.isSet;
 
@@ -1650,7 +1651,7 @@ void EditView::DrawForeground(Surface *surface, const EditModel &model, const Vi
 
 	// Foreground drawing loop
 	BreakFinder bfFore(ll, &model.sel, lineRange, posLineStart, xStartVisible,
-		(((phasesDraw == phasesOne) && selBackDrawn) || vsDraw.selColours.fore.isSet), model.pdoc, &model.reprs, &vsDraw);
+		(((phasesDraw == phasesOne) && selBackDrawn) || vsDraw.selColours.fore.isSet), model.pdoc, &model.reprs, &vsDraw, breakPositions);
 
 	while (bfFore.More()) {
 
@@ -1898,6 +1899,13 @@ void EditView::DrawLine(Surface *surface, const EditModel &model, const ViewStyl
 	const Range lineRangeIncludingEnd = ll->SubLineRange(subLine, LineLayout::Scope::includeEnd);
 	const XYACCUMULATOR subLineStart = ll->positions[lineRange.start];
 
+	if ((phasesDraw == phasesOne) && (phase & drawBack)) {
+		// Fill the whole line once so the platform layer can skip filling text runs
+		// that have the same background as the line.
+		surface->FillRectangle(rcLine, background.isSet ? background :
+			vsDraw.styles[STYLE_DEFAULT].back);
+	}
+
 	if ((ll->wrapIndent != 0) && (subLine > 0)) {
 		if (phase & drawBack) {
 			DrawWrapIndentAndMarker(surface, vsDraw, ll, xStart, rcLine, background, customDrawWrapMarker, model.caret.active);
@@ -1988,6 +1996,9 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, PRectan
 	// serifs and italic stems for aliased text.
 	const int leftTextOverlap = ((model.xOffset == 0) && (vsDraw.leftMarginWidth > 0)) ? 1 : 0;
 
+	linesLaidOut = 0;
+	posCache.monospaceRuns = 0;
+
 	// Do the painting
 	if (rcArea.right > vsDraw.textStart - leftTextOverlap) {
 
@@ -2037,15 +2048,18 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, PRectan
 
 		Sci::Line lineDocPrevious = -1;	// Used to avoid laying out one document line multiple times
 		AutoLineLayout ll(llc, nullptr);
-		std::vector<DrawPhase> phases;
+		// Fixed size so painting does not allocate: one entry per phase bit at most.
+		DrawPhase phases[9];
+		size_t nPhases = 0;
 		if ((phasesDraw == phasesMultiple) && !bufferedDraw) {
 			for (DrawPhase phase = drawBack; phase <= drawCarets; phase = static_cast<DrawPhase>(phase * 2)) {
-				phases.push_back(phase);
+				phases[nPhases++] = phase;
 			}
 		} else {
-			phases.push_back(drawAll);
+			phases[nPhases++] = drawAll;
 		}
-		for (const DrawPhase &phase : phases) {
+		for (size_t iPhase = 0; iPhase < nPhases; iPhase++) {
+			const DrawPhase phase = phases[iPhase];
 			int ypos = 0;
 			if (!bufferedDraw)
 				ypos += screenLinePaintFirst * vsDraw.lineHeight;
@@ -2069,6 +2083,7 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, PRectan
 					ll.Set(RetrieveLineLayout(lineDoc, model));
 					LayoutLine(model, lineDoc, surface, vsDraw, ll, model.wrapWidth);
 					lineDocPrevious = lineDoc;
+					linesLaidOut++;
 				}
 #if defined(TIME_PAINTING)
 				durLayout += ep.Duration(true);
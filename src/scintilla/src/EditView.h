@@ -68,6 +68,10 @@ class EditView {
   PhasesDraw phasesDraw;
 
   int lineWidthMaxSeen;
+  /** Number of document lines laid out by the most recent PaintText call. */
+  int linesLaidOut;
+  /** Break positions for BreakFinder, reused across lines so drawing does not allocate. */
+  std::vector<int> breakPositions;
 
   bool additionalCaretsBlink;
   bool additionalCaretsVisible;
@@ -148,7 +152,7 @@ class EditView {
   void DrawBackground(Surface* surface, const EditModel& model, const ViewStyle& vsDraw,
                       const LineLayout* ll, PRectangle rcLine, Range lineRange,
                       Sci::Position posLineStart, int xStart, int subLine,
-                      ColourOptional background) const;
+                      ColourOptional background);
   void DrawForeground(Surface* surface, const EditModel& model, const ViewStyle& vsDraw,
                       const LineLayout* ll, Sci::Line lineVisible, PRectangle rcLine,
                       Range lineRange, Sci::Position posLineStart, int xStart, int subLine,
@@ -173,6 +173,7 @@ Editor::Editor() : durationWrapOneLine(0.00001, 0.000001, 0.0001) {
   willRedrawAll = false;
   idleStyling = SC_IDLESTYLING_NONE;
   needIdleStyling = false;
+  stylingBudget = 0.0;
 
   modEventMask = SC_MODEVENTMASKALL;
   commandEvents = true;
@@ -508,7 +509,7 @@ void Editor::RedrawSelMargin(Sci::Line line, bool allAfter) {
     rcMarkers.Move(-ptOrigin.x, -ptOrigin.y);
     wMargin.InvalidateRectangle(rcMarkers);
   } else {
-    wMain.InvalidateRectangle(rcMarkers);
+    RedrawRect(rcMarkers);
   }
 }
 
@@ -5012,7 +5013,8 @@ Sci::Position Editor::PositionAfterMaxStyling(Sci::Position posMax, bool scrolli
 
   // Try to keep time taken by styling reasonable so interaction remains smooth.
   // When scrolling, allow less time to ensure responsive
-  const double secondsAllowed = scrolling ? 0.005 : 0.02;
+  // A platform supplied budget replaces both defaults.
+  const double secondsAllowed = (stylingBudget > 0.0) ? stylingBudget : (scrolling ? 0.005 : 0.02);
 
   const Sci::Line linesToStyle = Sci::clamp(
       static_cast<int>(secondsAllowed / pdoc->durationStyleOneLine.Duration()), 10, 0x10000);
@@ -7586,7 +7588,6 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
       Document* doc = new Document(static_cast<int>(lParam));
       doc->AddRef();
       doc->Allocate(static_cast<Sci::Position>(wParam));
-      pcs = ContractionStateCreate(pdoc->IsLarge());
       return reinterpret_cast<sptr_t>(doc);
     }
 
@@ -7606,7 +7607,6 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
       doc->AddRef();
       doc->Allocate(static_cast<Sci::Position>(wParam));
       doc->SetUndoCollection(false);
-      pcs = ContractionStateCreate(pdoc->IsLarge());
       return reinterpret_cast<sptr_t>(static_cast<ILoader*>(doc));
     }
 
@@ -237,6 +237,7 @@ class Editor : public EditModel, public DocWatcher {
   WorkNeeded workNeeded;
   int idleStyling;
   bool needIdleStyling;
+  double stylingBudget;  // Seconds allowed per bounded styling step, 0 for the defaults
 
   int modEventMask;
   bool commandEvents;
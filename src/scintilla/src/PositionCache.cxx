@@ -446,11 +446,13 @@ void BreakFinder::Insert(Sci::Position val) {
 }
 
 BreakFinder::BreakFinder(const LineLayout *ll_, const Selection *psel, Range lineRange_, Sci::Position posLineStart_,
-	int xStart, bool breakForSelection, const Document *pdoc_, const SpecialRepresentations *preprs_, const ViewStyle *pvsDraw) :
+	int xStart, bool breakForSelection, const Document *pdoc_, const SpecialRepresentations *preprs_, const ViewStyle *pvsDraw,
+	std::vector<int> &selAndEdge_) :
 	ll(ll_),
 	lineRange(lineRange_),
 	posLineStart(posLineStart_),
 	nextBreak(static_cast<int>(lineRange_.start)),
+	selAndEdge(selAndEdge_),
 	saeCurrentPos(0),
 	saeNext(0),
 	subBreak(-1),
@@ -458,6 +460,8 @@ BreakFinder::BreakFinder(const LineLayout *ll_, const Selection *psel, Range lin
 	encodingFamily(pdoc_->CodePageFamily()),
 	preprs(preprs_) {
 
+	selAndEdge.clear();
+
 	// Search for first visible break
 	// First find the first visible character
 	if (xStart > 0.0f)
@@ -641,6 +645,8 @@ PositionCache::PositionCache() {
 	clock = 1;
 	pces.resize(0x400);
 	allClear = true;
+	monospaceLayout = true;
+	monospaceRuns = 0;
 }
 
 PositionCache::~PositionCache() {
@@ -662,9 +668,33 @@ void PositionCache::SetSize(size_t size_) {
 	pces.resize(size_);
 }
 
+static bool AllGraphicASCII(const char *s, unsigned int len) noexcept {
+	for (unsigned int i = 0; i < len; i++) {
+		const unsigned char ch = s[i];
+		if ((ch < ' ') || (ch > '~')) {
+			return false;
+		}
+	}
+	return true;
+}
+
 void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 	const char *s, unsigned int len, XYPOSITION *positions, const Document *pdoc) {
 
+	const Style &style = vstyle.styles[styleNumber];
+	if (monospaceLayout && style.monospaceASCII && AllGraphicASCII(s, len)) {
+		// Fixed pitch font: no need to measure or cache.
+		// Accumulate and round like Surface::MeasureWidths so both paths give the same positions.
+		monospaceRuns++;
+		const float monospaceCharacterWidth = static_cast<float>(style.monospaceCharacterWidth);
+		float x = 0;
+		for (unsigned int i = 0; i < len; i++) {
+			x += monospaceCharacterWidth;
+			positions[i] = static_cast<XYPOSITION>(static_cast<int>(x + 0.5f));
+		}
+		return;
+	}
+
 	allClear = false;
 	size_t probe = pces.size();	// Out of bounds
 	if ((!pces.empty()) && (len < 30)) {
@@ -202,7 +202,7 @@ class BreakFinder {
   Range lineRange;
   Sci::Position posLineStart;
   int nextBreak;
-  std::vector<int> selAndEdge;
+  std::vector<int>& selAndEdge;
   unsigned int saeCurrentPos;
   int saeNext;
   int subBreak;
@@ -220,7 +220,7 @@ class BreakFinder {
   BreakFinder(const LineLayout* ll_, const Selection* psel, Range lineRange_,
               Sci::Position posLineStart_, int xStart, bool breakForSelection,
               const Document* pdoc_, const SpecialRepresentations* preprs_,
-              const ViewStyle* pvsDraw);
+              const ViewStyle* pvsDraw, std::vector<int>& selAndEdge_);
   // Deleted so BreakFinder objects can not be copied.
   BreakFinder(const BreakFinder&) = delete;
   BreakFinder(BreakFinder&&) = delete;
@@ -237,6 +237,11 @@ class PositionCache {
   bool allClear;
 
  public:
+  /** When false, fixed pitch fonts are measured like proportional ones. */
+  bool monospaceLayout;
+  /** Number of runs positioned by the fixed pitch path since the counter was last reset. */
+  unsigned int monospaceRuns;
+
   PositionCache();
   // Deleted so PositionCache objects can not be copied.
   PositionCache(const PositionCache&) = delete;
@@ -632,6 +632,8 @@ void LexState::SetLexerModule(const LexerModule *lex) {
 			instance = lexCurrent->Create();
 			interfaceVersion = instance->Version();
 		}
+		convergent = instance && instance->PrivateCall(lpcConvergent, nullptr);
+		lexedTo = -1;
 		pdoc->LexerChanged();
 	}
 }
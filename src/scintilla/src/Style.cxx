@@ -72,6 +72,8 @@ void FontMeasurements::ClearMeasurements() noexcept {
 	aveCharWidth = 1;
 	spaceWidth = 1;
 	sizeZoomed = 2;
+	monospaceASCII = false;
+	monospaceCharacterWidth = 1;
 }
 
 Style::Style() : FontSpecification() {
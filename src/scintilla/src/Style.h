@@ -50,6 +50,8 @@ struct FontMeasurements {
   XYPOSITION aveCharWidth;
   XYPOSITION spaceWidth;
   int sizeZoomed;
+  bool monospaceASCII;  // All printable ASCII characters have the same advance
+  XYPOSITION monospaceCharacterWidth;
   FontMeasurements() noexcept;
   void ClearMeasurements() noexcept;
 };
@@ -53,6 +53,17 @@ void FontRealised::Realise(Surface &surface, int zoomLevel, int technology, cons
 	capitalHeight = surface.Ascent(font) - surface.InternalLeading(font);
 	aveCharWidth = surface.AverageCharWidth(font);
 	spaceWidth = surface.WidthText(font, " ", 1);
+
+	// Detect fixed pitch once per font so that layout can compute the positions of
+	// printable ASCII runs without measuring each character.
+	static const char probe[] = "iIlW0 .,mM_@";
+	const int lenProbe = static_cast<int>(sizeof(probe) - 1);
+	const XYPOSITION widthProbe = surface.WidthText(font, probe, 1);
+	monospaceASCII = widthProbe > 0;
+	for (int i = 1; (i < lenProbe) && monospaceASCII; i++) {
+		monospaceASCII = surface.WidthText(font, probe + i, 1) == widthProbe;
+	}
+	monospaceCharacterWidth = monospaceASCII ? widthProbe : aveCharWidth;
 }
 
 ViewStyle::ViewStyle() : markers(MARKER_MAX + 1), indicators(INDICATOR_MAX + 1) {
@@ -0,0 +1,17 @@
+; 计算数组元素之和
+        section code
+        xdef    _sum
+_sum:   movem.l d2-d3/a2,-(sp)
+        move.l  16(sp),a0       ; array
+        move.l  20(sp),d1       ; count
+        moveq   #0,d0
+        bra.s   .next
+.loop:  add.l   (a0)+,d0
+.next:  dbra    d1,.loop
+        movem.l (sp)+,d2-d3/a2
+        rts
+
+        section data
+table:  dc.l    $10,$20,%1010,'AB'
+msg:    dc.b    "done",10,0
+        even
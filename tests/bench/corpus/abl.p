@@ -0,0 +1,19 @@
+/* 客户报表 */
+DEFINE VARIABLE iCount AS INTEGER NO-UNDO.
+DEFINE VARIABLE cName AS CHARACTER NO-UNDO INITIAL "report".
+
+FOR EACH Customer NO-LOCK WHERE Customer.Balance > 1000:
+    iCount = iCount + 1.
+    DISPLAY Customer.Name Customer.Balance.
+END.
+
+IF iCount = 0 THEN
+    MESSAGE "no customers" VIEW-AS ALERT-BOX.
+ELSE DO:
+    MESSAGE cName iCount.
+END.
+
+PROCEDURE showTotal:
+    DEFINE INPUT PARAMETER pTotal AS DECIMAL NO-UNDO.
+    MESSAGE "total:" pTotal.
+END PROCEDURE.
@@ -0,0 +1,28 @@
+-- 简单的栈
+with Ada.Text_IO; use Ada.Text_IO;
+
+procedure Stack_Demo is
+   type Int_Array is array (Positive range <>) of Integer;
+   Items : Int_Array (1 .. 16);
+   Top   : Natural := 0;
+
+   procedure Push (X : Integer) is
+   begin
+      Top := Top + 1;
+      Items (Top) := X;
+   end Push;
+
+   function Pop return Integer is
+      X : constant Integer := Items (Top);
+   begin
+      Top := Top - 1;
+      return X;
+   end Pop;
+begin
+   for I in 1 .. 10 loop
+      Push (I * 16#FF#);
+   end loop;
+   while Top > 0 loop
+      Put_Line ("value:" & Integer'Image (Pop));
+   end loop;
+end Stack_Demo;
@@ -0,0 +1,15 @@
+# 字符串长度
+        .text
+        .globl  strlen_s
+strlen_s:
+        movq    %rdi, %rax
+1:      cmpb    $0, (%rax)
+        je      2f
+        incq    %rax
+        jmp     1b
+2:      subq    %rdi, %rax
+        ret
+
+        .data
+msg:    .asciz  "hello\n"
+vals:   .long   0x10, 020, 'A'
@@ -0,0 +1,18 @@
+; 复制内存块
+        .model  small
+        .code
+copy    proc    near
+        push    si
+        push    di
+        mov     cx, [bp+8]
+        cld
+        rep     movsb
+        pop     di
+        pop     si
+        ret
+copy    endp
+
+        .data
+msg     db      "copy done", 0Dh, 0Ah, '$'
+count   dw      10h, 0FFFFh
+        end
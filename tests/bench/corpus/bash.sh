@@ -0,0 +1,31 @@
+#!/bin/bash
+# 编译并运行测试
+set -e
+
+BUILD_DIR=${BUILD_DIR:-build}
+JOBS=$(nproc)
+
+usage() {
+  echo "Usage: $0 [-c] [-j jobs]" >&2
+  exit 1
+}
+
+while getopts "cj:" opt; do
+  case $opt in
+    c) rm -rf "$BUILD_DIR" ;;
+    j) JOBS=$OPTARG ;;
+    *) usage ;;
+  esac
+done
+
+mkdir -p "$BUILD_DIR"
+for f in tests/*.cc; do
+  if [ -f "$f" ]; then
+    echo "compiling ${f##*/}"
+  fi
+done
+
+scons -j"$JOBS" && ./bin/runTest --gtest_filter='code_edit.*' || {
+  echo 'tests failed'
+  exit 2
+}
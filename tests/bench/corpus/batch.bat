@@ -0,0 +1,21 @@
+@echo off
+rem Build all targets
+setlocal enabledelayedexpansion
+
+set BUILD_DIR=build
+if not exist "%BUILD_DIR%" mkdir "%BUILD_DIR%"
+
+for %%f in (src\*.c) do (
+  echo compiling %%~nf
+  cl /nologo /c "%%f" /Fo"%BUILD_DIR%\%%~nf.obj" || goto :error
+)
+
+:: link everything
+link /nologo /out:"%BUILD_DIR%\app.exe" "%BUILD_DIR%\*.obj"
+if errorlevel 1 goto :error
+echo done
+exit /b 0
+
+:error
+echo build failed with %errorlevel%
+exit /b 1
@@ -0,0 +1,24 @@
+# 构建配置
+cmake_minimum_required(VERSION 3.10)
+project(demo VERSION 1.2 LANGUAGES C CXX)
+
+option(WITH_TESTS "build tests" ON)
+set(SOURCES src/main.c src/util.c)
+
+if(WIN32)
+  add_definitions(-DWIN32_LEAN_AND_MEAN)
+elseif(APPLE)
+  set(CMAKE_MACOSX_RPATH 1)
+endif()
+
+add_executable(demo ${SOURCES})
+target_include_directories(demo PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/include)
+
+foreach(t IN ITEMS a b c)
+  message(STATUS "target ${t}")
+endforeach()
+
+if(WITH_TESTS)
+  enable_testing()
+  add_test(NAME demo_test COMMAND demo --self-test)
+endif()
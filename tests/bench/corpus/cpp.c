@@ -0,0 +1,64 @@
+/**
+ * 简单的环形缓冲区实现，用于词法分析器的性能测试。
+ */
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RING_BUFFER_MAGIC 0x52424646u
+#define RING_BUFFER_ALIGN(n) (((n) + 7) & ~7)
+
+typedef struct _ring_buffer_t {
+  uint32_t magic;
+  uint32_t r;
+  uint32_t w;
+  uint32_t capacity;
+  uint8_t* data;
+} ring_buffer_t;
+
+/* 创建指定容量的缓冲区 */
+static ring_buffer_t* ring_buffer_create(uint32_t capacity) {
+  ring_buffer_t* rb = (ring_buffer_t*)calloc(1, sizeof(ring_buffer_t));
+  if (rb == NULL) {
+    return NULL;
+  }
+
+  rb->magic = RING_BUFFER_MAGIC;
+  rb->capacity = RING_BUFFER_ALIGN(capacity);
+  rb->data = (uint8_t*)malloc(rb->capacity);
+
+  return rb;
+}
+
+static int ring_buffer_write(ring_buffer_t* rb, const void* buff, uint32_t size) {
+  const uint8_t* p = (const uint8_t*)buff;
+  uint32_t i = 0;
+
+#if defined(RING_BUFFER_DEBUG)
+  fprintf(stderr, "write %u bytes: \"%s\"\n", size, "data");
+#endif /*RING_BUFFER_DEBUG*/
+
+  for (i = 0; i < size; i++) {
+    uint32_t next = (rb->w + 1) % rb->capacity;
+    if (next == rb->r) {
+      break; // full
+    }
+    rb->data[rb->w] = p[i];
+    rb->w = next;
+  }
+
+  return (int)i;
+}
+
+static void ring_buffer_destroy(ring_buffer_t* rb) {
+  if (rb != NULL && rb->magic == RING_BUFFER_MAGIC) {
+    free(rb->data);
+    memset(rb, 0x00, sizeof(*rb));
+    free(rb);
+  }
+}
+
+#endif /*RING_BUFFER_H*/
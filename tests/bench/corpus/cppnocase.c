@@ -0,0 +1,19 @@
+/* 不区分大小写的关键字 */
+#INCLUDE <stdio.h>
+#Define MAX 16
+
+STATIC INT table[MAX];
+
+Int Lookup(Const Char* key) {
+  For (int i = 0; i < MAX; i++) {
+    IF (table[i] == key[0]) RETURN i;
+  }
+  return -1;
+}
+
+int main(void) {
+  // 填充
+  for (int i = 0; i < MAX; i++) table[i] = 'a' + i;
+  printf("%d\n", Lookup("c"));
+  Return 0x0;
+}
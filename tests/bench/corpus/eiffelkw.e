@@ -0,0 +1,29 @@
+-- 账户类
+class
+    SAVINGS_ACCOUNT
+
+create
+    make
+
+feature -- 初始化
+    make (initial: INTEGER)
+        require
+            non_negative: initial >= 0
+        do
+            balance := initial
+        ensure
+            set: balance = initial
+        end
+
+feature
+    balance: INTEGER
+
+    deposit (amount: INTEGER)
+        do
+            balance := balance + amount
+            io.put_string ("deposit%N")
+        end
+
+invariant
+    balance >= 0
+end
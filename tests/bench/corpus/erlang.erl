@@ -0,0 +1,23 @@
+%% 计数服务
+-module(counter).
+-export([start/0, loop/1, inc/1]).
+
+start() ->
+    spawn(?MODULE, loop, [0]).
+
+inc(Pid) ->
+    Pid ! {inc, self()},
+    receive
+        {ok, N} -> N
+    after 1000 ->
+        timeout
+    end.
+
+loop(N) ->
+    receive
+        {inc, From} ->
+            From ! {ok, N + 1},
+            loop(N + 1);
+        stop ->
+            io:format("stopped at ~p~n", [N])
+    end.
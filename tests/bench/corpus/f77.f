@@ -0,0 +1,16 @@
+C     计算阶乘
+      PROGRAM FACT
+      INTEGER N, I
+      REAL*8 F
+      N = 10
+      F = 1.0D0
+      DO 10 I = 1, N
+         F = F * I
+   10 CONTINUE
+      WRITE (*, 100) N, F
+  100 FORMAT (' N=', I3, ' F=', F12.1)
+      IF (F .GT. 1.0D6) THEN
+         PRINT *, 'LARGE'
+      END IF
+      STOP
+      END
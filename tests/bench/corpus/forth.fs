@@ -0,0 +1,14 @@
+\ 阶乘和列表
+: fact ( n -- n! )
+  dup 1 > if dup 1- recurse * then ;
+
+: squares ( n -- )
+  0 do i dup * . loop cr ;
+
+( 测试 )
+10 fact . cr
+5 squares
+variable total  0 total !
+: add ( n -- ) total +! ;
+3 add 4 add total @ .
+$FF . s" done" type cr
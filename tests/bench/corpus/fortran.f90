@@ -0,0 +1,26 @@
+! 矩阵乘法
+module matmul_mod
+  implicit none
+contains
+  subroutine mult(a, b, c, n)
+    integer, intent(in) :: n
+    real(8), intent(in) :: a(n, n), b(n, n)
+    real(8), intent(out) :: c(n, n)
+    integer :: i, j, k
+    c = 0.0d0
+    do j = 1, n
+      do k = 1, n
+        do i = 1, n
+          c(i, j) = c(i, j) + a(i, k) * b(k, j)
+        end do
+      end do
+    end do
+  end subroutine mult
+end module matmul_mod
+
+program main
+  use matmul_mod
+  real(8) :: a(2, 2) = reshape([1d0, 2d0, 3d0, 4d0], [2, 2]), c(2, 2)
+  call mult(a, a, c, 2)
+  print '(A, 4F8.2)', 'c = ', c
+end program main
@@ -0,0 +1,20 @@
+' 排序
+Declare Sub BubbleSort(a() As Integer)
+
+Dim Shared values(1 To 8) As Integer = {5, 3, 8, 1, 9, 2, &HFF, 4}
+
+Sub BubbleSort(a() As Integer)
+    Dim As Integer i, j
+    For i = LBound(a) To UBound(a) - 1
+        For j = i + 1 To UBound(a)
+            If a(i) > a(j) Then Swap a(i), a(j)
+        Next
+    Next
+End Sub
+
+/' 块注释 '/
+BubbleSort(values())
+For i As Integer = 1 To 8
+    Print values(i);
+Next
+Print "done"
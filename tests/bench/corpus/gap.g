@@ -0,0 +1,19 @@
+# 群的阶
+G := SymmetricGroup(4);
+Print("order: ", Size(G), "\n");
+
+CountInvolutions := function(group)
+    local count, g;
+    count := 0;
+    for g in group do
+        if Order(g) = 2 then
+            count := count + 1;
+        fi;
+    od;
+    return count;
+end;
+
+if CountInvolutions(G) > 5 then
+    Print("many involutions\n");
+fi;
+L := List([1..10], i -> i^2);
@@ -0,0 +1,22 @@
+-- 快速排序
+module Main where
+
+import Data.List (foldl')
+
+{- 块注释 {- 嵌套 -} -}
+quicksort :: Ord a => [a] -> [a]
+quicksort []     = []
+quicksort (p:xs) = quicksort [x | x <- xs, x < p] ++ [p] ++ quicksort [x | x <- xs, x >= p]
+
+data Shape = Circle Double | Rect Double Double deriving (Show, Eq)
+
+area :: Shape -> Double
+area (Circle r) = pi * r * r
+area (Rect w h) = w * h
+
+main :: IO ()
+main = do
+  print (quicksort [5, 3, 0x1F, 1, 4])
+  let total = foldl' (+) 0 (map area [Circle 1.0, Rect 2 3])
+  putStrLn ("total: " ++ show total)
+  print 'c'
@@ -0,0 +1,14 @@
+;; 阶乘和列表操作
+(defun factorial (n)
+  (if (<= n 1)
+      1
+      (* n (factorial (- n 1)))))
+
+(defmacro while (test &body body)
+  `(loop (unless ,test (return)) ,@body))
+
+#| 块注释 |#
+(let ((items '(1 2 3 #x1F))
+      (name "list"))
+  (format t "~a: ~{~a ~}~%" name (mapcar #'factorial items))
+  (print #\a))
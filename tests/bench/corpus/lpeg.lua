@@ -0,0 +1,13 @@
+-- 解析数字列表
+local lpeg = require("lpeg")
+local P, R, S, C, Ct = lpeg.P, lpeg.R, lpeg.S, lpeg.C, lpeg.Ct
+
+local space = S(" \t\n")^0
+local digit = R("09")
+local number = C(P("-")^-1 * digit^1 * (P(".") * digit^1)^-1) / tonumber
+local list = Ct(space * number * (space * P(",") * space * number)^0 * space)
+
+local result = list:match("1, 2.5, -3, 42")
+for i, v in ipairs(result) do
+  print(i, v)
+end
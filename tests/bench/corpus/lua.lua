@@ -0,0 +1,31 @@
+-- 简单的队列
+local Queue = {}
+Queue.__index = Queue
+
+function Queue.new()
+  return setmetatable({first = 1, last = 0, items = {}}, Queue)
+end
+
+function Queue:push(value)
+  self.last = self.last + 1
+  self.items[self.last] = value
+end
+
+function Queue:pop()
+  if self.first > self.last then
+    return nil, "queue is empty"
+  end
+  local value = self.items[self.first]
+  self.items[self.first] = nil
+  self.first = self.first + 1
+  return value
+end
+
+--[[ 测试 ]]
+local q = Queue.new()
+for i = 1, 10 do q:push(i * 2.5) end
+while true do
+  local v = q:pop()
+  if not v then break end
+  print(string.format("%.1f", v))
+end
@@ -0,0 +1,17 @@
+# 构建规则
+CC ?= gcc
+CFLAGS = -O2 -Wall -I../src -DSCI_LEXER
+OBJS := $(patsubst %.c,%.o,$(wildcard *.c))
+
+.PHONY: all clean
+
+all: runTest
+
+runTest: $(OBJS)
+	$(CC) -o $@ $^ -lgtest -lpthread
+
+%.o: %.c
+	$(CC) $(CFLAGS) -c $< -o $@
+
+clean:
+	rm -f $(OBJS) runTest
@@ -0,0 +1,19 @@
+% 求解线性方程组
+function x = solve_system(A, b)
+    % 检查维度
+    if size(A, 1) ~= numel(b)
+        error('dimension mismatch');
+    end
+    x = A \ b;
+end
+
+A = [4 -2 1; -2 4 -2; 1 -2 4];
+b = [11; -16; 17];
+x = solve_system(A, b');
+for k = 1:numel(x)
+    fprintf('x(%d) = %.3f\n', k, x(k));
+end
+%{
+块注释
+%}
+s = "string";
@@ -0,0 +1,29 @@
+(* 栈模块，中文注释 *)
+MODULE Stack;
+
+FROM InOut IMPORT WriteString, WriteInt, WriteLn;
+
+CONST Max = 16;
+VAR items: ARRAY [1..Max] OF INTEGER;
+    top: CARDINAL;
+
+PROCEDURE Push(x: INTEGER);
+BEGIN
+  INC(top);
+  items[top] := x
+END Push;
+
+PROCEDURE Pop(): INTEGER;
+BEGIN
+  DEC(top);
+  RETURN items[top + 1]
+END Pop;
+
+BEGIN
+  top := 0;
+  Push(0FFH); Push(12);
+  WHILE top > 0 DO
+    WriteInt(Pop(), 4); WriteLn
+  END;
+  WriteString("完成")
+END Stack.
@@ -0,0 +1,21 @@
+-- 订单汇总
+SET NOCOUNT ON;
+DECLARE @total MONEY = 0;
+
+CREATE TABLE #orders (
+    id INT IDENTITY(1, 1) PRIMARY KEY,
+    customer NVARCHAR(50) NOT NULL,
+    amount MONEY
+);
+
+INSERT INTO #orders (customer, amount) VALUES (N'张三', 12.5), ('Bob', 30);
+
+SELECT customer, SUM(amount) AS total
+FROM #orders WITH (NOLOCK)
+GROUP BY customer
+HAVING SUM(amount) > 10
+ORDER BY total DESC;
+
+IF @@ROWCOUNT = 0
+    PRINT 'empty';
+DROP TABLE #orders;
@@ -0,0 +1,13 @@
+-- 用户表
+CREATE TABLE IF NOT EXISTS `users` (
+  `id` INT UNSIGNED NOT NULL AUTO_INCREMENT,
+  `name` VARCHAR(64) NOT NULL DEFAULT '',
+  `created` DATETIME DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4;
+
+INSERT INTO users (name) VALUES ('alice'), ("bob");
+SET @n := 0;
+SELECT id, name, @n := @n + 1 AS row_no FROM users WHERE name LIKE 'a%' LIMIT 10;
+/* 删除旧数据 */
+DELETE FROM users WHERE created < NOW() - INTERVAL 30 DAY;
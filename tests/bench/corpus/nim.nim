@@ -0,0 +1,19 @@
+# 计算斐波那契
+import strutils, sequtils
+
+type
+  Point = object
+    x, y: float
+
+proc fib(n: int): int =
+  if n < 2: n
+  else: fib(n - 1) + fib(n - 2)
+
+#[ 块注释 ]#
+let nums = toSeq(1..10).mapIt(fib(it))
+echo nums.join(", ")
+var p = Point(x: 1.5, y: 0x10.float)
+for i in countup(0, 3):
+  echo "i = ", i, " ", p.x
+const msg = """多行
+字符串"""
@@ -0,0 +1,17 @@
+# 数值积分
+function r = trap(f, a, b, n)
+  h = (b - a) / n;
+  x = a:h:b;
+  y = f(x);
+  r = h * (sum(y) - (y(1) + y(end)) / 2);
+endfunction
+
+f = @(x) x .^ 2;
+printf("integral: %f\n", trap(f, 0, 1, 100));
+if exist("OCTAVE_VERSION", "builtin")
+  disp('running in octave');
+endif
+%{
+块注释
+%}
+A = eye(3) * 2;
@@ -0,0 +1,29 @@
+{ 排序程序 }
+program SortDemo;
+
+uses SysUtils;
+
+const
+  N = 8;
+var
+  a: array[1..N] of Integer = (5, 3, 8, 1, 9, 2, $FF, 4);
+  i, j, t: Integer;
+
+procedure Print;
+var k: Integer;
+begin
+  for k := 1 to N do Write(a[k], ' ');
+  WriteLn;
+end;
+
+begin
+  (* 冒泡排序 *)
+  for i := 1 to N - 1 do
+    for j := i + 1 to N do
+      if a[i] > a[j] then
+      begin
+        t := a[i]; a[i] := a[j]; a[j] := t;
+      end;
+  Print;
+  WriteLn('done');
+end.
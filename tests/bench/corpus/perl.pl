@@ -0,0 +1,27 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+
+# Count words in the given files
+my %count;
+my $total = 0;
+
+foreach my $file (@ARGV) {
+    open(my $fh, '<', $file) or die "Cannot open $file: $!";
+    while (my $line = <$fh>) {
+        chomp $line;
+        next if $line =~ /^\s*#/;
+        for my $word (split /\W+/, lc $line) {
+            next unless length $word;
+            $count{$word}++;
+            $total++;
+        }
+    }
+    close($fh);
+}
+
+my @top = (sort { $count{$b} <=> $count{$a} || $a cmp $b } keys %count)[0 .. 9];
+printf "%-20s %6d\n", $_, $count{$_} for grep { defined } @top;
+print <<"END";
+Total: $total words
+END
@@ -0,0 +1,22 @@
+<?php
+// 用户列表
+namespace App;
+
+class User {
+    private array $roles = [];
+    public function __construct(private string $name) {}
+    public function addRole(string $role): void { $this->roles[] = $role; }
+    public function __toString(): string {
+        return sprintf("%s (%s)", $this->name, implode(', ', $this->roles));
+    }
+}
+
+/* 测试 */
+$u = new User("张三");
+$u->addRole('admin');
+foreach ([1, 2, 0x1F] as $i => $v) {
+    echo "$i => {$v}\n";
+}
+echo <<<EOT
+name: $u
+EOT;
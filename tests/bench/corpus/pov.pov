@@ -0,0 +1,23 @@
+// 简单场景
+#include "colors.inc"
+#declare R = 1.5;
+
+camera {
+  location <0, 2, -5>
+  look_at <0, 0, 0>
+}
+
+light_source { <10, 10, -10> color White }
+
+sphere {
+  <0, R, 0>, R
+  pigment { color rgb <1, 0.2, 0.2> }
+  finish { specular 0.6 }
+}
+
+/* 地面 */
+plane { y, 0 pigment { checker color White color Gray } }
+
+#for (I, 0, 5)
+  box { <I, 0, 3>, <I + 0.5, 0.5, 3.5> pigment { Blue } }
+#end
@@ -0,0 +1,18 @@
+' 计算总和
+#COMPILE EXE
+#DIM ALL
+
+FUNCTION Total(BYVAL n AS LONG) AS LONG
+    LOCAL i AS LONG, s AS LONG
+    FOR i = 1 TO n
+        s = s + i
+    NEXT
+    FUNCTION = s
+END FUNCTION
+
+FUNCTION PBMAIN() AS LONG
+    LOCAL msg AS STRING
+    msg = "total: " & STR$(Total(100))
+    MSGBOX msg
+    IF Total(10) > 50 THEN PRINT "big" ELSE PRINT "small"
+END FUNCTION
@@ -0,0 +1,24 @@
+# 清理旧文件
+param(
+    [string]$Path = "C:\Temp",
+    [int]$Days = 30
+)
+
+<# 块注释
+   中文说明 #>
+function Remove-OldFiles {
+    param([string]$Dir, [int]$Age)
+    $limit = (Get-Date).AddDays(-$Age)
+    Get-ChildItem -Path $Dir -Recurse -File |
+        Where-Object { $_.LastWriteTime -lt $limit } |
+        ForEach-Object {
+            Write-Host "remove $($_.FullName)"
+            Remove-Item $_.FullName -WhatIf
+        }
+}
+
+if (Test-Path $Path) {
+    Remove-OldFiles -Dir $Path -Age $Days
+} else {
+    Write-Error 'path not found'
+}
@@ -0,0 +1,23 @@
+; 列表操作
+EnableExplicit
+
+Structure Item
+  Name.s
+  Count.i
+EndStructure
+
+NewList Items.Item()
+
+Procedure.i Total(List l.Item())
+  Protected sum.i = 0
+  ForEach l()
+    sum + l()\Count
+  Next
+  ProcedureReturn sum
+EndProcedure
+
+AddElement(Items()) : Items()\Name = "a" : Items()\Count = 3
+AddElement(Items()) : Items()\Name = "b" : Items()\Count = $10
+If Total(Items()) > 10
+  Debug "total: " + Str(Total(Items()))
+EndIf
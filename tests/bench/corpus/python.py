@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""Simple task scheduler used as a lexer benchmark corpus."""
+
+import heapq
+import time
+from dataclasses import dataclass, field
+
+
+@dataclass(order=True)
+class Task:
+    deadline: float
+    name: str = field(compare=False)
+    retries: int = field(default=0, compare=False)
+
+    def __repr__(self):
+        return f"Task({self.name!r}, deadline={self.deadline:.3f})"
+
+
+class Scheduler:
+    '''Run tasks in deadline order.'''
+
+    def __init__(self, clock=time.monotonic):
+        self._queue = []
+        self._clock = clock
+
+    def add(self, name, delay=0.0):
+        task = Task(self._clock() + delay, name)
+        heapq.heappush(self._queue, task)
+        return task
+
+    def run(self, handler, max_retries=3):
+        done = []
+        while self._queue:
+            task = heapq.heappop(self._queue)
+            try:
+                handler(task)
+            except (ValueError, RuntimeError) as e:
+                if task.retries < max_retries:
+                    task.retries += 1
+                    heapq.heappush(self._queue, task)
+                else:
+                    print("giving up on %s: %s" % (task.name, e))
+                continue
+            done.append(task)
+        return done
+
+
+if __name__ == "__main__":
+    s = Scheduler()
+    for i in range(10):
+        s.add("job-%d" % i, delay=i * 0.01)
+    print([t.name for t in s.run(lambda t: None)])
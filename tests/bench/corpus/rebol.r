@@ -0,0 +1,17 @@
+REBOL [
+    Title: "示例"
+    Date: 1-Jan-2020
+]
+
+; 求和
+sum: func [block [block!] /local total] [
+    total: 0
+    foreach n block [total: total + n]
+    total
+]
+
+print ["sum:" sum [1 2 3 4]]
+data: #{48656C6C6F}
+url: http://www.example.com
+either 10 > 5 [print "yes"] [print "no"]
+email: user@example.com
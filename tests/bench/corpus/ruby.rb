@@ -0,0 +1,36 @@
+# frozen_string_literal: true
+
+require 'json'
+
+module Inventory
+  # 库存中的一项
+  class Item
+    attr_reader :name, :quantity
+
+    def initialize(name, quantity = 0)
+      @name = name
+      @quantity = quantity
+    end
+
+    def add(n)
+      raise ArgumentError, "negative: #{n}" if n.negative?
+
+      @quantity += n
+      self
+    end
+
+    def to_h
+      { name: @name, quantity: @quantity }
+    end
+  end
+
+  def self.load(path)
+    JSON.parse(File.read(path)).map do |h|
+      Item.new(h['name'], h.fetch('quantity', 0))
+    end
+  end
+end
+
+items = [Inventory::Item.new('bolt', 10), Inventory::Item.new(:nut.to_s)]
+items.each { |i| i.add(5) }
+puts items.map(&:to_h).to_json
@@ -0,0 +1,25 @@
+// 单词计数
+use std::collections::HashMap;
+
+/// 统计每个单词出现的次数
+fn count_words(text: &str) -> HashMap<String, usize> {
+    let mut counts = HashMap::new();
+    for word in text.split_whitespace() {
+        *counts.entry(word.to_lowercase()).or_insert(0) += 1;
+    }
+    counts
+}
+
+#[derive(Debug, Clone)]
+struct Point<T> { x: T, y: T }
+
+fn main() {
+    let text = "the quick brown fox jumps over the lazy dog";
+    let counts = count_words(text);
+    let mut keys: Vec<_> = counts.iter().collect();
+    keys.sort_by(|a, b| b.1.cmp(a.1));
+    println!("{:?}", &keys[..3]);
+    let p = Point { x: 0x1F_u32, y: 2 };
+    let raw = r#"C:\path"#;
+    println!("{:?} {} {}", p, raw, 'c');
+}
@@ -0,0 +1,16 @@
+` 计算总和
+int sum = 0
+for int i in 1 .. 10
+    sum + i
+/for
+print "sum:", sum
+
+int fact(int n)
+    if n < 2 return 1
+    return n * fact(n - 1)
+return
+
+text msg = "done"
+if sum > 50
+    print msg
+/if
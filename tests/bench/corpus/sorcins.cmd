@@ -0,0 +1,10 @@
+; 配置脚本
+SET SYSTEM MODE=RUN
+DEFINE TAG PUMP1 TYPE=DIGITAL ADDRESS=100
+DEFINE TAG LEVEL1 TYPE=ANALOG ADDRESS=200 RANGE=0,100
+IF LEVEL1 > 80 THEN
+    SET PUMP1 ON
+ELSE
+    SET PUMP1 OFF
+ENDIF
+LOG "level: " LEVEL1
@@ -0,0 +1,24 @@
+<'
+// 数据包生成
+type kind_t : [SHORT, LONG];
+
+struct packet {
+    kind : kind_t;
+    len  : uint (bits: 8);
+    data : list of byte;
+    keep kind == SHORT => len < 16;
+    keep data.size() == len;
+
+    show() is {
+        out("packet: ", kind, " len ", len);
+    };
+};
+
+extend sys {
+    packets : list of packet;
+    keep packets.size() == 10;
+    run() is also {
+        for each (p) in packets { p.show(); };
+    };
+};
+'>
@@ -0,0 +1,20 @@
+-- 订单统计
+CREATE TABLE IF NOT EXISTS orders (
+  id INTEGER PRIMARY KEY AUTOINCREMENT,
+  customer_id INTEGER NOT NULL,
+  amount DECIMAL(10, 2) DEFAULT 0.00,
+  status VARCHAR(16) CHECK (status IN ('new', 'paid', 'shipped')),
+  created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+
+/* 每个客户的订单总额 */
+SELECT c.name, COUNT(o.id) AS orders, SUM(o.amount) AS total
+FROM customers c
+LEFT JOIN orders o ON o.customer_id = c.id AND o.status <> 'new'
+WHERE c.created_at >= '2020-01-01'
+GROUP BY c.name
+HAVING SUM(o.amount) > 100
+ORDER BY total DESC
+LIMIT 20;
+
+UPDATE orders SET status = 'shipped' WHERE id IN (SELECT id FROM orders WHERE status = 'paid');
@@ -0,0 +1,22 @@
+/* 房间定义，中文注释 */
+#charset "us-ascii"
+#include <adv3.h>
+
+startRoom: Room 'Hall' 'the hall'
+    "A long hall with a door to the north. "
+    north = kitchen
+;
+
+kitchen: Room 'Kitchen' 'the kitchen'
+    "A small kitchen. "
+    south = startRoom
+;
+
++ apple: Food 'red apple' 'apple'
+    "It looks tasty. "
+    dobjFor(Eat) { action() { "Yum! "; inherited(); } }
+;
+
+modify Thing
+    describe() { say('名称: ' + name); }
+;
@@ -0,0 +1,20 @@
+# 读取配置
+proc read_config {file} {
+    set result [dict create]
+    set fh [open $file r]
+    while {[gets $fh line] >= 0} {
+        if {[regexp {^(\w+)\s*=\s*(.*)$} $line -> key value]} {
+            dict set result $key $value
+        }
+    }
+    close $fh
+    return $result
+}
+
+set cfg [dict create name "demo" size 0x10]
+foreach {k v} $cfg {
+    puts "$k = $v"
+}
+if {[info exists env(HOME)]} {
+    puts "home: $env(HOME)"
+}
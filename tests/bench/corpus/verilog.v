@@ -0,0 +1,20 @@
+// 计数器
+`timescale 1ns / 1ps
+module counter #(parameter WIDTH = 8) (
+    input  wire             clk,
+    input  wire             rst_n,
+    input  wire             en,
+    output reg [WIDTH-1:0]  count
+);
+    /* 同步计数 */
+    always @(posedge clk or negedge rst_n) begin
+        if (!rst_n)
+            count <= {WIDTH{1'b0}};
+        else if (en)
+            count <= count + 8'h01;
+    end
+
+    initial begin
+        $display("counter width %d", WIDTH);
+    end
+endmodule
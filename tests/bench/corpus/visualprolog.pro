@@ -0,0 +1,27 @@
+% 家族关系
+implement main
+    open core, console
+
+class facts
+    parent : (string Parent, string Child).
+
+clauses
+    parent("Tom", "Bob").
+    parent("Bob", "Ann").
+
+class predicates
+    grandparent : (string GP, string GC) nondeterm anyflow.
+clauses
+    grandparent(GP, GC) :-
+        parent(GP, P),
+        parent(P, GC).
+
+    /* 主程序 */
+    run() :-
+        foreach grandparent(X, Y) do
+            writef("% is grandparent of %\n", X, Y)
+        end foreach.
+end implement main
+
+goal
+    console::runUtf8(main::run).
@@ -0,0 +1,642 @@
+﻿/**
+ * File:   editor_bench.cc
+ * Author: AWTK Develop Team
+ * Brief:  编辑器性能测试。
+ *
+ * Copyright (c) 2020 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 AWTK Develop Team created
+ *
+ */
+
+#include "awtk.h"
+#include "tkc/fs.h"
+#include "tkc/utils.h"
+#include "tkc/platform.h"
+#include "tkc/time_now.h"
+#include "base/idle.h"
+#include "base/system_info.h"
+#include "lcd/lcd_mem_rgba8888.h"
+#include "code_edit/code_edit.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+
+/*直接访问ScintillaAWTK，用于设置词法分析器和查询样式分析的进度。*/
+#include "Platform.h"
+#include "ILoader.h"
+#include "ILexer.h"
+#include "Scintilla.h"
+#include "SciLexer.h"
+#include "CharacterCategory.h"
+#include "Position.h"
+#include "UniqueString.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "ContractionState.h"
+#include "CellBuffer.h"
+#include "CallTip.h"
+#include "KeyMap.h"
+#include "Indicator.h"
+#include "LineMarker.h"
+#include "Style.h"
+#include "ViewStyle.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "Selection.h"
+#include "PositionCache.h"
+#include "EditModel.h"
+#include "MarginView.h"
+#include "EditView.h"
+#include "Editor.h"
+#include "AutoComplete.h"
+#include "ScintillaBase.h"
+#include "scintilla/awtk/ScintillaAWTK.h"
+
+using Scintilla::ScintillaAWTK;
+
+/*
+ * 用法：editorBench [-l 用例] [-n 次数] [-o 输出文件]
+ *
+ * 单元测试只检查行为，耗时相关的测量放在这里。每个用例在新的编辑器上执行，
+ * 取最快一次的耗时，结果以 JSON 格式输出到标准输出或指定的文件。
+ */
+
+#define BENCH_DEFAULT_ITERATIONS 3
+#define BENCH_FILENAME "editor_bench.tmp.c"
+#define BENCH_BACKUP_FILENAME "editor_bench.tmp.c.bak"
+#define BENCH_STYLING_BLOCK \
+  "/* block\n * comment */\nstatic const char* s = \"str\"; // tail\n#define X 1\n"
+
+typedef struct _bench_options_t {
+  const char* name;
+  const char* output;
+  uint32_t iterations;
+} bench_options_t;
+
+typedef struct _bench_result_t {
+  std::string name;
+  double seconds;
+  std::vector<std::pair<std::string, double> > values;
+} bench_result_t;
+
+typedef bool (*bench_case_run_t)(bench_result_t* result);
+
+typedef struct _bench_case_t {
+  const char* name;
+  bench_case_run_t run;
+} bench_case_t;
+
+static void bench_usage(const char* app) {
+  fprintf(stderr, "Usage: %s [-l case] [-n iterations] [-o output.json]\n", app);
+}
+
+static bool bench_parse_options(bench_options_t* options, int argc, char** argv) {
+  options->name = NULL;
+  options->output = NULL;
+  options->iterations = BENCH_DEFAULT_ITERATIONS;
+
+  for (int i = 1; i < argc; i++) {
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (value == NULL) {
+      return false;
+    } else if (tk_str_eq(argv[i], "-l")) {
+      options->name = value;
+    } else if (tk_str_eq(argv[i], "-o")) {
+      options->output = value;
+    } else if (tk_str_eq(argv[i], "-n")) {
+      options->iterations = tk_max(tk_atoi(value), 1);
+    } else {
+      return false;
+    }
+    i++;
+  }
+
+  return true;
+}
+
+static std::string bench_repeat(const char* text, size_t min_size) {
+  std::string result;
+
+  while (result.size() < min_size) {
+    result += text;
+  }
+
+  return result;
+}
+
+static void bench_add_value(bench_result_t* result, const char* key, double value) {
+  result->values.push_back(std::make_pair(std::string(key), value));
+}
+
+/*编辑器的样式事件，记录空闲时分析的次数和耗时。*/
+typedef struct _bench_styling_t {
+  uint32_t idle_events;
+  uint32_t max_lines;
+  uint64_t duration_us;
+} bench_styling_t;
+
+static ret_t bench_on_styling(void* ctx, event_t* e) {
+  bench_styling_t* styling = (bench_styling_t*)ctx;
+  code_edit_styling_event_t* evt = (code_edit_styling_event_t*)e;
+
+  styling->duration_us += evt->duration_us;
+  styling->max_lines = tk_max(styling->max_lines, evt->lines);
+  if (evt->idle) {
+    styling->idle_events++;
+  }
+
+  return RET_OK;
+}
+
+static sptr_t bench_send(widget_t* w, unsigned int msg, uptr_t wparam, sptr_t lparam) {
+  ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(CODE_EDIT(w)->impl);
+  return impl->DefWndProc(msg, wparam, lparam);
+}
+
+static Sci::Position bench_end_styled(widget_t* w) {
+  return bench_send(w, SCI_GETENDSTYLED, 0, 0);
+}
+
+/*没有主题资源，直接设置词法分析器。*/
+static widget_t* bench_create_editor(int lexer) {
+  widget_t* w = code_edit_create(NULL, 0, 0, 300, 200);
+
+  widget_move_resize(w, 0, 0, 300, 200);
+  bench_send(w, SCI_SETLEXER, lexer, 0);
+
+  return w;
+}
+
+static bool bench_save(bench_result_t* result, bool_t atomic) {
+  uint64_t start = 0;
+  std::string text =
+      bench_repeat("static int sum(const int* a, int n) { return a[n - 1]; }\n", 8 * 1024 * 1024);
+  widget_t* w = bench_create_editor(SCLEX_NULL);
+  ret_t ret = widget_set_text_utf8(w, text.c_str());
+
+  if (ret == RET_OK) {
+    ret = code_edit_save(w, BENCH_FILENAME, FALSE);
+  }
+
+  if (ret == RET_OK) {
+    widget_set_prop_bool(w, CODE_EDIT_PROP_ATOMIC_SAVE, atomic);
+    widget_set_prop_bool(w, CODE_EDIT_PROP_KEEP_BACKUP, atomic);
+    code_edit_insert_text(w, 0, "/*new*/");
+
+    start = time_now_us();
+    ret = code_edit_save(w, BENCH_FILENAME, FALSE);
+    result->seconds = (time_now_us() - start) / 1000000.0;
+    bench_add_value(result, "bytes", text.size());
+  }
+
+  widget_destroy(w);
+  fs_remove_file(os_fs(), BENCH_FILENAME);
+  fs_remove_file(os_fs(), BENCH_BACKUP_FILENAME);
+
+  return ret == RET_OK;
+}
+
+static bool bench_save_plain(bench_result_t* result) {
+  return bench_save(result, FALSE);
+}
+
+static bool bench_save_atomic(bench_result_t* result) {
+  return bench_save(result, TRUE);
+}
+
+static bool bench_insert(bench_result_t* result, bool_t batch) {
+  uint64_t start = 0;
+  uint32_t redraws = 0;
+  const uint32_t count = 10000;
+  widget_t* w = bench_create_editor(SCLEX_CPP);
+  bool ok = true;
+
+  redraws = widget_get_prop_int(w, CODE_EDIT_PROP_REDRAW_REQUESTS, 0);
+  start = time_now_us();
+  if (batch) {
+    code_edit_begin_batch(w);
+  }
+  for (uint32_t i = 0; i < count && ok; i++) {
+    ok = code_edit_insert_text(w, 0xffffffff, "int a = 1;\n") == RET_OK;
+  }
+  if (batch) {
+    code_edit_end_batch(w);
+  }
+  result->seconds = (time_now_us() - start) / 1000000.0;
+  bench_add_value(result, "inserts", count);
+  bench_add_value(result, "redraw_requests",
+                  widget_get_prop_int(w, CODE_EDIT_PROP_REDRAW_REQUESTS, 0) - redraws);
+
+  widget_destroy(w);
+
+  return ok;
+}
+
+static bool bench_insert_plain(bench_result_t* result) {
+  return bench_insert(result, FALSE);
+}
+
+static bool bench_insert_batch(bench_result_t* result) {
+  return bench_insert(result, TRUE);
+}
+
+static ret_t bench_on_load_event(void* ctx, event_t* e) {
+  int32_t* events = (int32_t*)ctx;
+
+  if (e->type == EVT_PROGRESS) {
+    events[0]++;
+  } else if (e->type == EVT_DONE) {
+    events[1]++;
+  } else {
+    events[2]++;
+  }
+
+  return RET_OK;
+}
+
+/*在后台加载文件，统计总耗时和UI线程单次处理idle的最长阻塞。*/
+static bool bench_load_async(bench_result_t* result) {
+  uint64_t start = 0;
+  uint64_t stall = 0;
+  uint64_t max_stall = 0;
+  int32_t events[3] = {0, 0, 0};
+  std::string text = bench_repeat("static int sum(const int* a, int n) { return a[n - 1]; }\n",
+                                  16 * 1024 * 1024);
+  widget_t* w = bench_create_editor(SCLEX_NULL);
+  bool ok = file_write(BENCH_FILENAME, text.c_str(), text.size()) == RET_OK;
+
+  widget_on(w, EVT_PROGRESS, bench_on_load_event, events);
+  widget_on(w, EVT_DONE, bench_on_load_event, events);
+  widget_on(w, EVT_ERROR, bench_on_load_event, events);
+
+  start = time_now_us();
+  ok = ok && code_edit_load_async(w, BENCH_FILENAME) == RET_OK;
+  max_stall = time_now_us() - start;
+  while (ok && events[1] == 0 && events[2] == 0) {
+    stall = time_now_us();
+    idle_dispatch();
+    stall = time_now_us() - stall;
+    max_stall = tk_max(max_stall, stall);
+    sleep_ms(1);
+  }
+  result->seconds = (time_now_us() - start) / 1000000.0;
+  bench_add_value(result, "bytes", text.size());
+  bench_add_value(result, "progress_events", events[0]);
+  bench_add_value(result, "max_stall_us", max_stall);
+
+  widget_destroy(w);
+  fs_remove_file(os_fs(), BENCH_FILENAME);
+
+  return ok && events[1] == 1;
+}
+
+/*文档没有变化时重复读取文本，只返回缓存的快照。*/
+static bool bench_text_snapshot(bench_result_t* result) {
+  uint64_t start = 0;
+  uint32_t gets = 1000;
+  std::string text =
+      bench_repeat("static int sum(const int* a, int n) { return a[n - 1]; }\n", 1024 * 1024);
+  widget_t* w = bench_create_editor(SCLEX_NULL);
+  bool ok = widget_set_text_utf8(w, text.c_str()) == RET_OK;
+
+  start = time_now_us();
+  for (uint32_t i = 0; ok && i < gets; i++) {
+    ok = widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL) != NULL;
+  }
+  result->seconds = (time_now_us() - start) / 1000000.0;
+  bench_add_value(result, "bytes", text.size());
+  bench_add_value(result, "gets", gets);
+
+  widget_destroy(w);
+
+  return ok;
+}
+
+/*后台分析整个文档，统计总耗时和UI线程单次处理idle的最长阻塞。*/
+static bool bench_background_lexing(bench_result_t* result) {
+  uint64_t start = 0;
+  uint64_t stall = 0;
+  uint64_t max_stall = 0;
+  std::string text = bench_repeat(BENCH_STYLING_BLOCK, 4 * 1024 * 1024);
+  int32_t length = text.size();
+  widget_t* w = bench_create_editor(SCLEX_CPP);
+
+  code_edit_set_background_lexing(w, TRUE);
+
+  start = time_now_us();
+  widget_set_text_utf8(w, text.c_str());
+  while (bench_end_styled(w) < length) {
+    stall = time_now_us();
+    idle_dispatch();
+    max_stall = tk_max(max_stall, time_now_us() - stall);
+    sleep_ms(1);
+  }
+  result->seconds = (time_now_us() - start) / 1000000.0;
+  bench_add_value(result, "bytes", length);
+  bench_add_value(result, "max_stall_us", max_stall);
+
+  widget_destroy(w);
+
+  return true;
+}
+
+/*空闲时按预算分析到文档末尾，统计总耗时、分析次数和单次最多分析的行数。*/
+static bool bench_idle_styling(bench_result_t* result) {
+  canvas_t c;
+  uint64_t start = 0;
+  bench_styling_t styling;
+  rect_t r = rect_init(0, 0, 300, 200);
+  std::string text = bench_repeat(BENCH_STYLING_BLOCK, 1024 * 1024);
+  int32_t length = text.size();
+  lcd_t* lcd = lcd_mem_rgba8888_create(r.w, r.h, TRUE);
+  widget_t* w = bench_create_editor(SCLEX_CPP);
+
+  canvas_init(&c, lcd, font_manager());
+  canvas_set_clip_rect(&c, &r);
+  widget_set_text_utf8(w, text.c_str());
+  widget_set_prop_int(w, CODE_EDIT_PROP_IDLE_STYLING, SC_IDLESTYLING_ALL);
+  widget_set_prop_int(w, CODE_EDIT_PROP_STYLING_BUDGET_US, 200);
+
+  memset(&styling, 0x00, sizeof(styling));
+  widget_on(w, EVT_CODE_EDIT_STYLING, bench_on_styling, &styling);
+  start = time_now_us();
+  widget_paint(w, &c);
+  while (bench_end_styled(w) < length) {
+    idle_dispatch();
+  }
+  result->seconds = (time_now_us() - start) / 1000000.0;
+  bench_add_value(result, "lines", code_edit_get_line_count(w));
+  bench_add_value(result, "idle_steps", styling.idle_events);
+  bench_add_value(result, "max_lines", styling.max_lines);
+  bench_add_value(result, "styling_us", styling.duration_us);
+
+  widget_destroy(w);
+  canvas_reset(&c);
+  lcd_destroy(lcd);
+
+  return true;
+}
+
+/*
+ * 逐页滚动绘制整个文件，统计排版耗时和绘制的行数。monospace为false时关闭等宽快速路径，
+ * 与layout对比。monospace_runs是走等宽快速路径排版的文字段数，为0说明字体不是等宽的，
+ * 两个用例都是逐字测量。
+ */
+static bool bench_layout_with(bench_result_t* result, bool monospace) {
+  canvas_t c;
+  wheel_event_t e;
+  uint64_t start = 0;
+  int32_t lines = 0;
+  uint32_t runs = 0;
+  rect_t r = rect_init(0, 0, 300, 200);
+  std::string text = bench_repeat("  if (a[i] > 0) { sum += a[i]; }\n", 10000 * 33);
+  lcd_t* lcd = lcd_mem_rgba8888_create(r.w, r.h, TRUE);
+  widget_t* w = bench_create_editor(SCLEX_CPP);
+  ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(CODE_EDIT(w)->impl);
+
+  canvas_init(&c, lcd, font_manager());
+  canvas_set_clip_rect(&c, &r);
+  impl->SetMonospaceLayout(monospace);
+  code_edit_set_scroll_line(w, 10);
+  widget_set_text_utf8(w, text.c_str());
+
+  start = time_now_us();
+  for (int i = 0; i < 1000; i++) {
+    widget_paint(w, &c);
+    lines += widget_get_prop_int(w, CODE_EDIT_PROP_PAINTED_LINES, 0);
+    runs += impl->GetMonospaceRuns();
+    wheel_event_init(&e, EVT_WHEEL, w, -1);
+    widget_dispatch(w, (event_t*)&e);
+  }
+  result->seconds = (time_now_us() - start) / 1000000.0;
+  bench_add_value(result, "lines", lines);
+  bench_add_value(result, "monospace_runs", runs);
+
+  widget_destroy(w);
+  canvas_reset(&c);
+  lcd_destroy(lcd);
+
+  return monospace || runs == 0;
+}
+
+static bool bench_layout(bench_result_t* result) {
+  return bench_layout_with(result, true);
+}
+
+static bool bench_layout_measured(bench_result_t* result) {
+  return bench_layout_with(result, false);
+}
+
+/*重复绘制一屏C代码，报告每帧请求的填充次数、合并后实际提交的填充次数和省略的填充次数。*/
+static bool bench_fills(bench_result_t* result) {
+  canvas_t c;
+  uint64_t start = 0;
+  rect_t r = rect_init(0, 0, 300, 200);
+  std::string text = bench_repeat(
+      "/* sum positive items */\n"
+      "static int sum(const int* a, int n) {\n"
+      "  int s = 0;\n"
+      "  for (int i = 0; i < n; i++) {\n"
+      "    if (a[i] > 0) s += a[i]; // \"positive\"\n"
+      "  }\n"
+      "  return s;\n"
+      "}\n",
+      4096);
+  lcd_t* lcd = lcd_mem_rgba8888_create(r.w, r.h, TRUE);
+  widget_t* w = bench_create_editor(SCLEX_CPP);
+
+  canvas_init(&c, lcd, font_manager());
+  canvas_set_clip_rect(&c, &r);
+  bench_send(w, SCI_SETKEYWORDS, 0, (sptr_t)"int for if return static const");
+  widget_set_text_utf8(w, text.c_str());
+  widget_paint(w, &c);
+
+  start = time_now_us();
+  for (int i = 0; i < 1000; i++) {
+    widget_paint(w, &c);
+  }
+  result->seconds = (time_now_us() - start) / 1000000.0;
+  bench_add_value(result, "fill_requests", widget_get_prop_int(w, CODE_EDIT_PROP_FILL_REQUESTS, 0));
+  bench_add_value(result, "fill_rects", widget_get_prop_int(w, CODE_EDIT_PROP_FILL_RECTS, 0));
+  bench_add_value(result, "fills_elided", widget_get_prop_int(w, CODE_EDIT_PROP_FILLS_ELIDED, 0));
+
+  widget_destroy(w);
+  canvas_reset(&c);
+  lcd_destroy(lcd);
+
+  return true;
+}
+
+static bool bench_parallel_lexing(bench_result_t* result, uint32_t threads) {
+  uint64_t start = 0;
+  std::string text = "#ifndef BIG_H\n#define BIG_H\n#include <stdio.h>\n#define FEATURE 1\n\n";
+  widget_t* w = bench_create_editor(SCLEX_CPP);
+  int32_t length = 0;
+
+  text += bench_repeat(
+      "static int f(int x) {\n  const char* s = \"str\\\"ing\";\n\n  if (x > 0) {\n"
+      "    return x; // tail\n  }\n#if FEATURE\n  x++;\n#else\n  x--;\n#endif\n"
+      "  return -x;\n}\n\n",
+      4 * 1024 * 1024);
+  text += "#endif /*BIG_H*/\n";
+  length = text.size();
+
+  code_edit_set_lex_threads(w, threads);
+  code_edit_set_background_lexing(w, TRUE);
+
+  start = time_now_us();
+  widget_set_text_utf8(w, text.c_str());
+  while (bench_end_styled(w) < length) {
+    idle_dispatch();
+    sleep_ms(1);
+  }
+  result->seconds = (time_now_us() - start) / 1000000.0;
+  bench_add_value(result, "bytes", length);
+  bench_add_value(result, "threads", threads);
+  bench_add_value(result, "chunks", widget_get_prop_int(w, CODE_EDIT_PROP_LEX_CHUNKS, 0));
+
+  widget_destroy(w);
+
+  return true;
+}
+
+static bool bench_parallel_lexing_1(bench_result_t* result) {
+  return bench_parallel_lexing(result, 1);
+}
+
+static bool bench_parallel_lexing_4(bench_result_t* result) {
+  return bench_parallel_lexing(result, 4);
+}
+
+static const bench_case_t s_bench_cases[] = {
+    {"save_plain", bench_save_plain},
+    {"save_atomic", bench_save_atomic},
+    {"insert_plain", bench_insert_plain},
+    {"insert_batch", bench_insert_batch},
+    {"load_async", bench_load_async},
+    {"text_snapshot", bench_text_snapshot},
+    {"background_lexing", bench_background_lexing},
+    {"idle_styling", bench_idle_styling},
+    {"layout", bench_layout},
+    {"layout_measured", bench_layout_measured},
+    {"fills", bench_fills},
+    {"parallel_lexing_1", bench_parallel_lexing_1},
+    {"parallel_lexing_4", bench_parallel_lexing_4},
+};
+
+static void bench_append_string(std::string& json, const char* str) {
+  json += '"';
+  for (const char* p = str; *p; p++) {
+    if (*p == '"' || *p == '\\') {
+      json += '\\';
+    }
+    json += *p;
+  }
+  json += '"';
+}
+
+static std::string bench_to_json(const bench_options_t* options,
+                                 const std::vector<bench_result_t>& results) {
+  char buff[128];
+  std::string json = "{\n  \"iterations\": ";
+
+  tk_snprintf(buff, sizeof(buff), "%u,\n  \"cases\": [", options->iterations);
+  json += buff;
+
+  for (size_t i = 0; i < results.size(); i++) {
+    const bench_result_t& r = results[i];
+
+    json += i == 0 ? "\n    {\"name\": " : ",\n    {\"name\": ";
+    bench_append_string(json, r.name.c_str());
+    tk_snprintf(buff, sizeof(buff), ", \"seconds\": %.6f", r.seconds);
+    json += buff;
+    for (size_t k = 0; k < r.values.size(); k++) {
+      json += ", ";
+      bench_append_string(json, r.values[k].first.c_str());
+      tk_snprintf(buff, sizeof(buff), ": %.0f", r.values[k].second);
+      json += buff;
+    }
+    json += "}";
+  }
+  json += "\n  ]\n}\n";
+
+  return json;
+}
+
+int main(int argc, char** argv) {
+  bench_options_t options;
+  std::vector<bench_result_t> results;
+  std::string json;
+
+  if (!bench_parse_options(&options, argc, argv)) {
+    bench_usage(argv[0]);
+    return 1;
+  }
+
+  platform_prepare();
+  system_info_init(APP_SIMULATOR, NULL, "./");
+  tk_init_internal();
+
+  for (size_t i = 0; i < ARRAY_SIZE(s_bench_cases); i++) {
+    const bench_case_t* iter = s_bench_cases + i;
+    bench_result_t best;
+
+    if (options.name != NULL && !tk_str_eq(options.name, iter->name)) {
+      continue;
+    }
+
+    best.seconds = 0;
+    for (uint32_t n = 0; n < options.iterations; n++) {
+      bench_result_t result;
+
+      result.name = iter->name;
+      result.seconds = 0;
+      if (!iter->run(&result)) {
+        fprintf(stderr, "%s failed\n", iter->name);
+        tk_deinit_internal();
+        return 1;
+      }
+
+      if (n == 0 || result.seconds < best.seconds) {
+        best = result;
+      }
+    }
+
+    fprintf(stderr, "%-20s %10.3f ms\n", best.name.c_str(), best.seconds * 1000);
+    results.push_back(best);
+  }
+
+  tk_deinit_internal();
+
+  json = bench_to_json(&options, results);
+  if (options.output != NULL) {
+    if (file_write(options.output, json.c_str(), json.size()) != RET_OK) {
+      fprintf(stderr, "write %s failed\n", options.output);
+      return 1;
+    }
+  } else {
+    fputs(json.c_str(), stdout);
+  }
+
+  return 0;
+}
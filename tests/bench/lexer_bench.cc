@@ -0,0 +1,467 @@
+/**
+ * File:   lexer_bench.cc
+ * Author: AWTK Develop Team
+ * Brief:  词法分析器性能测试。
+ *
+ * Copyright (c) 2020 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 AWTK Develop Team created
+ *
+ */
+
+#include "tkc/fs.h"
+#include "tkc/mem.h"
+#include "tkc/path.h"
+#include "tkc/utils.h"
+#include "tkc/platform.h"
+#include "tkc/time_now.h"
+
+#include <new>
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif /*__GLIBC__*/
+
+#include "Platform.h"
+#include "ILoader.h"
+#include "ILexer.h"
+#include "Scintilla.h"
+#include "SciLexer.h"
+#include "CharacterCategory.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "LexerModule.h"
+#include "Catalogue.h"
+
+using namespace Scintilla;
+
+/*
+ * 用法：lexerBench [-c 语料目录] [-l 词法分析器] [-m 1] [-n 次数] [-s 最小字节数] [-o 输出文件]
+ *
+ * 语料目录中的文件按词法分析器的名称命名（如 cpp.c、python.py、hypertext.html），名称中
+ * 不能用在文件名里的'/'换成'_'（如 PL_M.plm），默认只运行有对应语料的词法分析器。没有对应语料的词法分析器分析的是别的语言，结果不代表
+ * 实际的性能，只在用 -l 指定或 -m 1 时在全部语料拼接成的 mixed 语料上运行，结果中标记
+ * "mixed": true。语料重复拼接到最小字节数以上，每次在新的 Document 上用新的词法分析器实例
+ * 执行 Lex 和 Fold，取最快一次的耗时，结果以 JSON 格式输出到标准输出或指定的文件。
+ */
+
+#define BENCH_DEFAULT_CORPUS "tests/bench/corpus"
+#define BENCH_DEFAULT_ITERATIONS 3
+#define BENCH_DEFAULT_MIN_SIZE (1024 * 1024)
+#define BENCH_MIXED_CORPUS "mixed"
+
+/*统计词法分析过程中的堆分配次数、分配的字节数和内存峰值。*/
+static bool s_count_alloc = false;
+static uint64_t s_alloc_count = 0;
+static uint64_t s_alloc_total = 0;
+static int64_t s_alloc_bytes = 0;
+static int64_t s_alloc_peak = 0;
+
+static void bench_on_alloc(size_t size) {
+  s_alloc_bytes += size;
+  if (s_count_alloc) {
+    s_alloc_count++;
+    s_alloc_total += size;
+    if (s_alloc_bytes > s_alloc_peak) {
+      s_alloc_peak = s_alloc_bytes;
+    }
+  }
+}
+
+#if defined(__GLIBC__)
+/*
+ * glibc下同时统计malloc/calloc/realloc，覆盖TKMEM_ALLOC等C接口的分配。块的大小用
+ * malloc_usable_size得到；operator new直接使用__libc_malloc，不会重复统计。
+ */
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+extern "C" void __libc_free(void* p);
+
+#define BENCH_MALLOC __libc_malloc
+#define BENCH_FREE __libc_free
+
+extern "C" void* malloc(size_t size) {
+  void* p = __libc_malloc(size);
+
+  if (p != NULL) {
+    bench_on_alloc(malloc_usable_size(p));
+  }
+
+  return p;
+}
+
+extern "C" void* calloc(size_t n, size_t size) {
+  void* p = __libc_calloc(n, size);
+
+  if (p != NULL) {
+    bench_on_alloc(malloc_usable_size(p));
+  }
+
+  return p;
+}
+
+extern "C" void* realloc(void* p, size_t size) {
+  size_t old_size = p != NULL ? malloc_usable_size(p) : 0;
+  void* np = __libc_realloc(p, size);
+
+  if (np != NULL) {
+    s_alloc_bytes -= old_size;
+    bench_on_alloc(malloc_usable_size(np));
+  }
+
+  return np;
+}
+
+extern "C" void free(void* p) {
+  if (p != NULL) {
+    s_alloc_bytes -= malloc_usable_size(p);
+    __libc_free(p);
+  }
+}
+#else
+#define BENCH_MALLOC malloc
+#define BENCH_FREE free
+#endif /*__GLIBC__*/
+
+#define NEW_HEADER_SIZE 16
+
+void* operator new(size_t size) {
+  char* p = (char*)BENCH_MALLOC(size + NEW_HEADER_SIZE);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+
+  *(size_t*)p = size;
+  bench_on_alloc(size);
+
+  return p + NEW_HEADER_SIZE;
+}
+
+void operator delete(void* p) noexcept {
+  if (p != NULL) {
+    char* h = (char*)p - NEW_HEADER_SIZE;
+    s_alloc_bytes -= *(size_t*)h;
+    BENCH_FREE(h);
+  }
+}
+
+void operator delete(void* p, size_t size) noexcept {
+  operator delete(p);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return operator new(size);
+  } catch (...) {
+    return NULL;
+  }
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return operator new(size, std::nothrow);
+}
+
+void operator delete[](void* p) noexcept {
+  operator delete(p);
+}
+
+void operator delete[](void* p, size_t size) noexcept {
+  operator delete(p);
+}
+
+typedef struct _bench_options_t {
+  const char* corpus;
+  const char* lexer;
+  const char* output;
+  bool mixed;
+  uint32_t iterations;
+  uint32_t min_size;
+} bench_options_t;
+
+typedef struct _bench_result_t {
+  std::string name;
+  std::string corpus;
+  bool mixed;
+  int language;
+  size_t bytes;
+  int32_t lines;
+  double seconds;
+  uint64_t allocations;
+  uint64_t allocated_bytes;
+  size_t peak_bytes;
+} bench_result_t;
+
+static void bench_usage(const char* app) {
+  fprintf(stderr,
+          "Usage: %s [-c corpus_dir] [-l lexer] [-m 1] [-n iterations] [-s min_size] "
+          "[-o output.json]\n",
+          app);
+}
+
+static bool bench_parse_options(bench_options_t* options, int argc, char** argv) {
+  options->corpus = BENCH_DEFAULT_CORPUS;
+  options->lexer = NULL;
+  options->output = NULL;
+  options->mixed = false;
+  options->iterations = BENCH_DEFAULT_ITERATIONS;
+  options->min_size = BENCH_DEFAULT_MIN_SIZE;
+
+  for (int i = 1; i < argc; i++) {
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (value == NULL) {
+      return false;
+    } else if (tk_str_eq(argv[i], "-c")) {
+      options->corpus = value;
+    } else if (tk_str_eq(argv[i], "-l")) {
+      options->lexer = value;
+    } else if (tk_str_eq(argv[i], "-o")) {
+      options->output = value;
+    } else if (tk_str_eq(argv[i], "-m")) {
+      options->mixed = tk_atoi(value) != 0;
+    } else if (tk_str_eq(argv[i], "-n")) {
+      options->iterations = tk_max(tk_atoi(value), 1);
+    } else if (tk_str_eq(argv[i], "-s")) {
+      options->min_size = tk_max(tk_atoi(value), 1);
+    } else {
+      return false;
+    }
+    i++;
+  }
+
+  return true;
+}
+
+/*读取语料目录，文件名中第一个'.'之前的部分为词法分析器的名称。*/
+static bool bench_load_corpus(const char* dir_name, std::map<std::string, std::string>& corpus) {
+  fs_item_t item;
+  fs_dir_t* dir = fs_open_dir(os_fs(), dir_name);
+
+  if (dir == NULL) {
+    return false;
+  }
+
+  while (fs_dir_read(dir, &item) == RET_OK) {
+    char filename[MAX_PATH + 1];
+    uint32_t size = 0;
+    char* data = NULL;
+    const char* dot = strchr(item.name, '.');
+
+    if (!item.is_reg_file || dot == NULL || dot == item.name) {
+      continue;
+    }
+
+    path_build(filename, sizeof(filename), dir_name, item.name, NULL);
+    data = (char*)file_read(filename, &size);
+    if (data != NULL) {
+      corpus[std::string(item.name, dot - item.name)].assign(data, size);
+      TKMEM_FREE(data);
+    }
+  }
+  fs_dir_close(dir);
+
+  if (!corpus.empty()) {
+    std::string mixed;
+    for (const auto& iter : corpus) {
+      mixed += iter.second;
+      if (!mixed.empty() && mixed.back() != '\n') {
+        mixed += '\n';
+      }
+    }
+    corpus[BENCH_MIXED_CORPUS] = mixed;
+  }
+
+  return !corpus.empty();
+}
+
+static std::string bench_repeat(const std::string& text, size_t min_size) {
+  std::string result;
+
+  result.reserve(min_size + text.size());
+  while (result.size() < min_size) {
+    result += text;
+  }
+
+  return result;
+}
+
+/*文档和词法分析器在计时之外创建，只统计 Lex 和 Fold 的耗时和分配。*/
+static void bench_run_once(const LexerModule* lm, const std::string& text, bench_result_t* result) {
+  Document* doc = new Document(SC_DOCUMENTOPTION_DEFAULT);
+  ILexer* lexer = lm->Create();
+  Sci::Position length = text.size();
+  uint64_t start = 0;
+  double seconds = 0;
+
+  doc->AddRef();
+  doc->SetDBCSCodePage(SC_CP_UTF8);
+  doc->InsertString(0, text.c_str(), length);
+  lexer->PropertySet("fold", "1");
+
+  s_alloc_count = 0;
+  s_alloc_total = 0;
+  s_alloc_peak = s_alloc_bytes;
+  int64_t base = s_alloc_bytes;
+  s_count_alloc = true;
+
+  start = time_now_us();
+  lexer->Lex(0, length, 0, doc);
+  lexer->Fold(0, length, 0, doc);
+  seconds = (time_now_us() - start) / 1000000.0;
+
+  s_count_alloc = false;
+
+  if (result->seconds == 0 || seconds < result->seconds) {
+    result->seconds = seconds;
+  }
+  result->allocations = s_alloc_count;
+  result->allocated_bytes = s_alloc_total;
+  result->peak_bytes = s_alloc_peak - base;
+  result->bytes = length;
+  result->lines = doc->LinesTotal();
+
+  lexer->Release();
+  doc->Release();
+}
+
+static void bench_append_string(std::string& json, const char* str) {
+  json += '"';
+  for (const char* p = str; *p; p++) {
+    if (*p == '"' || *p == '\\') {
+      json += '\\';
+    }
+    json += *p;
+  }
+  json += '"';
+}
+
+static std::string bench_to_json(const bench_options_t* options,
+                                 const std::vector<bench_result_t>& results) {
+  char buff[256];
+  std::string json = "{\n  \"iterations\": ";
+
+  tk_snprintf(buff, sizeof(buff), "%u,\n  \"min_size\": %u,\n  \"lexers\": [", options->iterations,
+              options->min_size);
+  json += buff;
+
+  for (size_t i = 0; i < results.size(); i++) {
+    const bench_result_t& r = results[i];
+    double seconds = r.seconds > 0 ? r.seconds : 1e-9;
+
+    json += i == 0 ? "\n    {\"name\": " : ",\n    {\"name\": ";
+    bench_append_string(json, r.name.c_str());
+    json += ", \"corpus\": ";
+    bench_append_string(json, r.corpus.c_str());
+    json += r.mixed ? ", \"mixed\": true" : ", \"mixed\": false";
+    tk_snprintf(buff, sizeof(buff),
+                ", \"language\": %d, \"bytes\": %u, \"lines\": %d, \"seconds\": %.6f, "
+                "\"mb_per_s\": %.2f, \"lines_per_s\": %.0f",
+                r.language, (uint32_t)r.bytes, r.lines, r.seconds,
+                r.bytes / (1024.0 * 1024.0) / seconds, r.lines / seconds);
+    json += buff;
+    tk_snprintf(buff, sizeof(buff),
+                ", \"allocations\": %llu, \"allocated_bytes\": %llu, \"peak_bytes\": %llu}",
+                (unsigned long long)r.allocations, (unsigned long long)r.allocated_bytes,
+                (unsigned long long)r.peak_bytes);
+    json += buff;
+  }
+  json += "\n  ]\n}\n";
+
+  return json;
+}
+
+int main(int argc, char** argv) {
+  bench_options_t options;
+  std::map<std::string, std::string> corpus;
+  std::vector<bench_result_t> results;
+  std::string json;
+
+  if (!bench_parse_options(&options, argc, argv)) {
+    bench_usage(argv[0]);
+    return 1;
+  }
+
+  platform_prepare();
+  Scintilla_LinkLexers();
+
+  if (!bench_load_corpus(options.corpus, corpus)) {
+    fprintf(stderr, "no corpus found in %s\n", options.corpus);
+    return 1;
+  }
+
+  for (unsigned int i = 0; i < Catalogue::Count(); i++) {
+    const char* name = Catalogue::Name(i);
+    const LexerModule* lm = Catalogue::Find(name);
+    bench_result_t result;
+
+    if (lm == NULL || (options.lexer != NULL && !tk_str_eq(options.lexer, name))) {
+      continue;
+    }
+
+    std::string key = name;
+    std::replace(key.begin(), key.end(), '/', '_');
+    auto iter = corpus.find(key);
+    if (iter == corpus.end() || iter->first == BENCH_MIXED_CORPUS) {
+      if (options.lexer == NULL && !options.mixed) {
+        continue;
+      }
+      iter = corpus.find(BENCH_MIXED_CORPUS);
+    }
+
+    result.name = name;
+    result.corpus = iter->first;
+    result.mixed = iter->first == BENCH_MIXED_CORPUS;
+    result.language = lm->GetLanguage();
+    result.seconds = 0;
+
+    std::string text = bench_repeat(iter->second, options.min_size);
+    for (uint32_t n = 0; n < options.iterations; n++) {
+      bench_run_once(lm, text, &result);
+    }
+
+    fprintf(stderr, "%-16s %-10s %8.2f MB/s %10.0f lines/s %8llu allocs\n", name,
+            result.corpus.c_str(), result.bytes / (1024.0 * 1024.0) / tk_max(result.seconds, 1e-9),
+            result.lines / tk_max(result.seconds, 1e-9), (unsigned long long)result.allocations);
+    results.push_back(result);
+  }
+
+  json = bench_to_json(&options, results);
+  if (options.output != NULL) {
+    if (file_write(options.output, json.c_str(), json.size()) != RET_OK) {
+      fprintf(stderr, "write %s failed\n", options.output);
+      return 1;
+    }
+  } else {
+    fputs(json.c_str(), stdout);
+  }
+
+  return 0;
+}
@@ -1,5 +1,4 @@
-﻿#include "code_edit/code_edit.h"
-#include "gtest/gtest.h"
+﻿#include "code_edit_test_helper.h"
 
 TEST(code_edit, basic) {
   widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
@@ -40,3 +39,1051 @@ TEST(code_edit, basic) {
 
   widget_destroy(w);
 }
+
+static ret_t window_manager_paint_frame(canvas_t* c) {
+  paint_event_t e;
+
+  return widget_dispatch(window_manager(), paint_event_init(&e, EVT_AFTER_PAINT, window_manager(), c));
+}
+
+TEST(code_edit, skipped_frames) {
+  paint_fixture_t f;
+  widget_t* w = paint_fixture_init(&f);
+
+  ASSERT_EQ(widget_set_text_utf8(w, "int a = 0;\n"), RET_OK);
+  ASSERT_EQ(widget_get_prop_int(w, CODE_EDIT_PROP_SKIPPED_FRAMES, -1), 0);
+
+  /*编辑器参与绘制的帧不算跳过。*/
+  ASSERT_EQ(widget_paint(w, &f.c), RET_OK);
+  ASSERT_EQ(window_manager_paint_frame(&f.c), RET_OK);
+  ASSERT_EQ(widget_get_prop_int(w, CODE_EDIT_PROP_SKIPPED_FRAMES, -1), 0);
+
+  /*其它控件重绘而编辑器没有脏区的帧计为跳过。*/
+  ASSERT_EQ(window_manager_paint_frame(&f.c), RET_OK);
+  ASSERT_EQ(window_manager_paint_frame(&f.c), RET_OK);
+  ASSERT_EQ(widget_get_prop_int(w, CODE_EDIT_PROP_SKIPPED_FRAMES, -1), 2);
+
+  ASSERT_EQ(widget_paint(w, &f.c), RET_OK);
+  ASSERT_EQ(window_manager_paint_frame(&f.c), RET_OK);
+  ASSERT_EQ(widget_get_prop_int(w, CODE_EDIT_PROP_SKIPPED_FRAMES, -1), 2);
+
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, dirty_rect) {
+  rect_t r;
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+
+  widget_move_resize(w, 0, 0, 300, 200);
+  ASSERT_EQ(widget_set_text_utf8(w, "aaa\nbbb\nccc\nddd\n"), RET_OK);
+  ASSERT_EQ(code_edit_insert_text(w, 8, "x"), RET_OK);
+  ASSERT_EQ(code_edit_get_dirty_rect(w, &r, TRUE), RET_OK);
+
+  ASSERT_EQ(code_edit_insert_text(w, 9, "y"), RET_OK);
+  ASSERT_EQ(code_edit_get_dirty_rect(w, &r, TRUE), RET_OK);
+  ASSERT_GT(r.w, 0);
+  ASSERT_GT(r.h, 0);
+  ASSERT_EQ(r.y, 2 * r.h);
+  ASSERT_STREQ(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), "aaa\nbbb\nxyccc\nddd\n");
+
+  ASSERT_EQ(code_edit_get_dirty_rect(w, &r, FALSE), RET_OK);
+  ASSERT_EQ(r.w, 0);
+  ASSERT_EQ(r.h, 0);
+
+  widget_destroy(w);
+}
+
+TEST(code_edit, paint_clip) {
+  paint_fixture_t f;
+  widget_t* w = paint_fixture_init(&f);
+  int32_t full = 0;
+
+  ASSERT_EQ(widget_set_text_utf8(w, repeat_text("int a = 0;\n", 100).c_str()), RET_OK);
+
+  ASSERT_EQ(paint_fixture_paint(&f, 0, 0, 300, 200), RET_OK);
+  full = widget_get_prop_int(w, CODE_EDIT_PROP_PAINTED_LINES, 0);
+  ASSERT_EQ(full, 200 / (int32_t)sci_send(w, SCI_TEXTHEIGHT, 0, 0) + 1);
+
+  /*裁剪区只有一个像素高时只排版一行。*/
+  ASSERT_EQ(paint_fixture_paint(&f, 0, 0, 300, 1), RET_OK);
+  ASSERT_EQ(widget_get_prop_int(w, CODE_EDIT_PROP_PAINTED_LINES, 0), 1);
+
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, monospace_layout) {
+  paint_fixture_t f;
+  widget_t* w = paint_fixture_init(&f);
+
+  /*字宽不是整数时，等宽快速路径与逐字测量的位置取整方式相同。*/
+  code_edit_set_zoom(w, 0);
+  sci_send(w, SCI_STYLESETSIZE, STYLE_DEFAULT, 11);
+  sci_send(w, SCI_STYLECLEARALL, 0, 0);
+  ASSERT_EQ(widget_set_text_utf8(w, "abcd\nabcd\xC3\xA9\n"), RET_OK);
+  widget_paint(w, &f.c);
+
+  for (int i = 1; i <= 4; i++) {
+    sptr_t x = sci_send(w, SCI_POINTXFROMPOSITION, 0, i) - sci_send(w, SCI_POINTXFROMPOSITION, 0, 0);
+    ASSERT_EQ(x, sci_send(w, SCI_POINTXFROMPOSITION, 0, 5 + i) -
+                     sci_send(w, SCI_POINTXFROMPOSITION, 0, 5));
+  }
+
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, font_switches) {
+  paint_fixture_t f;
+  widget_t* w = paint_fixture_init(&f);
+  int32_t lines = 0;
+  int32_t switches = 0;
+
+  ASSERT_EQ(widget_set_text_utf8(w, repeat_text("int a = 0;\n", 100).c_str()), RET_OK);
+
+  widget_paint(w, &f.c);
+  widget_paint(w, &f.c);
+  lines = widget_get_prop_int(w, CODE_EDIT_PROP_PAINTED_LINES, 0);
+  switches = widget_get_prop_int(w, CODE_EDIT_PROP_FONT_SWITCHES, 0);
+
+  /*所有行使用同一字体，连续绘制时不应每行都切换字体。*/
+  ASSERT_GT(lines, 1);
+  ASSERT_GT(switches, 0);
+  ASSERT_LT(switches, lines);
+
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, font_cache) {
+  paint_fixture_t f;
+  widget_t* w1 = paint_fixture_init(&f);
+  widget_t* w2 = NULL;
+  int32_t hits = 0;
+  int32_t misses = 0;
+
+  ASSERT_EQ(widget_set_text_utf8(w1, "int a = 0;\n"), RET_OK);
+  widget_paint(w1, &f.c);
+
+  hits = widget_get_prop_int(w1, CODE_EDIT_PROP_FONT_CACHE_HITS, 0);
+  misses = widget_get_prop_int(w1, CODE_EDIT_PROP_FONT_CACHE_MISSES, 0);
+  ASSERT_GT(misses, 0);
+
+  /*相同样式的第二个编辑器复用已经创建的字体。*/
+  w2 = code_edit_create(NULL, 0, 0, 300, 200);
+  widget_move_resize(w2, 0, 0, 300, 200);
+  ASSERT_EQ(widget_set_text_utf8(w2, "int b = 0;\n"), RET_OK);
+  widget_paint(w2, &f.c);
+
+  ASSERT_EQ(widget_get_prop_int(w2, CODE_EDIT_PROP_FONT_CACHE_MISSES, 0), misses);
+  ASSERT_GT(widget_get_prop_int(w2, CODE_EDIT_PROP_FONT_CACHE_HITS, 0), hits);
+
+  widget_destroy(w2);
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, font_cache_lru) {
+  Scintilla::Font fonts[65];
+  Scintilla::Font font;
+  Scintilla::FontCacheStats stats;
+  uint32_t misses = 0;
+
+  /*字号带小数时不与整数字号共用字体。*/
+  Scintilla::FontCacheGetStats(&stats);
+  misses = stats.misses;
+  fonts[0].Create(Scintilla::FontParameters("default", 200.5f));
+  fonts[1].Create(Scintilla::FontParameters("default", 200.0f));
+  Scintilla::FontCacheGetStats(&stats);
+  ASSERT_EQ(stats.misses, misses + 2);
+  fonts[0].Release();
+  fonts[1].Release();
+
+  /*没有引用的字体超过上限时删除最久没有使用的，刚释放的字体仍然可以复用。*/
+  for (int i = 0; i < 65; i++) {
+    fonts[i].Create(Scintilla::FontParameters("default", 100.0f + i));
+  }
+  for (int i = 0; i < 65; i++) {
+    fonts[i].Release();
+  }
+
+  Scintilla::FontCacheGetStats(&stats);
+  misses = stats.misses;
+  font.Create(Scintilla::FontParameters("default", 164.0f));
+  Scintilla::FontCacheGetStats(&stats);
+  ASSERT_EQ(stats.misses, misses);
+  font.Create(Scintilla::FontParameters("default", 100.0f));
+  Scintilla::FontCacheGetStats(&stats);
+  ASSERT_EQ(stats.misses, misses + 1);
+  font.Release();
+}
+
+TEST(code_edit, font_fallback) {
+  Scintilla::Font font;
+  Scintilla::Font same;
+  Scintilla::FontCacheStats stats;
+  uint32_t lookups = 0;
+
+  /*没有粗体字体资源时使用常规字体，而不是缺省字体。*/
+  Scintilla::FontCacheGetStats(&stats);
+  lookups = stats.lookups;
+  font.Create(Scintilla::FontParameters("default", 31.0f, SC_WEIGHT_BOLD));
+  ASSERT_STREQ(Scintilla::FontGetName(font), "default");
+  Scintilla::FontCacheGetStats(&stats);
+  ASSERT_EQ(stats.lookups, lookups + 2);
+
+  /*找不到的结果也保存在字体中，再次使用时不再查找。*/
+  same.Create(Scintilla::FontParameters("default", 31.0f, SC_WEIGHT_BOLD));
+  Scintilla::FontCacheGetStats(&stats);
+  ASSERT_EQ(stats.lookups, lookups + 2);
+  same.Release();
+
+  /*常规字体也不存在时使用缺省字体。*/
+  font.Create(Scintilla::FontParameters("no_such_font", 31.0f, SC_WEIGHT_NORMAL, true));
+  ASSERT_TRUE(Scintilla::FontGetName(font) == NULL);
+  Scintilla::FontCacheGetStats(&stats);
+  ASSERT_EQ(stats.lookups, lookups + 4);
+  font.Release();
+}
+
+TEST(code_edit, fill_bench) {
+  paint_fixture_t f;
+  widget_t* w = paint_fixture_init(&f);
+  int32_t requests = 0;
+  int32_t fills = 0;
+  std::string text = repeat_text(
+      "/* sum positive items */\n"
+      "static int sum(const int* a, int n) {\n"
+      "  int s = 0;\n"
+      "  for (int i = 0; i < n; i++) {\n"
+      "    if (a[i] > 0) s += a[i]; // \"positive\"\n"
+      "  }\n"
+      "  return s;\n"
+      "}\n",
+      10);
+
+  sci_send(w, SCI_SETLEXER, SCLEX_CPP, 0);
+  sci_send(w, SCI_SETKEYWORDS, 0, (sptr_t)"int for if return static const");
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+
+  widget_paint(w, &f.c);
+  widget_paint(w, &f.c);
+  requests = widget_get_prop_int(w, CODE_EDIT_PROP_FILL_REQUESTS, 0);
+  fills = widget_get_prop_int(w, CODE_EDIT_PROP_FILL_RECTS, 0);
+  ASSERT_EQ(sci_send(w, SCI_GETSTYLEAT, 25, 0), SCE_C_WORD);
+
+  /*
+   * 缺省的两阶段绘制先逐段填充一行的背景，关键字、标识符、运算符、数字和注释都使用缺省背景色，
+   * 同一行上相邻的同色填充合并为一次canvas_fill_rect。
+   */
+  ASSERT_GT(fills, 0);
+  ASSERT_LT(fills, requests);
+
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, fills_elided) {
+  paint_fixture_t f;
+  widget_t* w = paint_fixture_init(&f);
+
+  code_edit_set_show_line_number(w, TRUE);
+  ASSERT_EQ(widget_set_text_utf8(w, "int a;\nint b;\nint c;\nint d;\n"), RET_OK);
+
+  widget_paint(w, &f.c);
+  widget_paint(w, &f.c);
+
+  /*行号的背景已经由边栏背景画好，不再重复填充。*/
+  ASSERT_GT(widget_get_prop_int(w, CODE_EDIT_PROP_FILLS_ELIDED, 0), 0);
+  ASSERT_GT(widget_get_prop_int(w, CODE_EDIT_PROP_FILL_REQUESTS, 0), 0);
+
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, fills_one_phase) {
+  paint_fixture_t f;
+  widget_t* w = paint_fixture_init(&f);
+  int32_t lines = 0;
+  std::string text = repeat_text("static int sum = a[i] + 10; // \"sum\"\n", 20);
+
+  sci_send(w, SCI_SETLEXER, SCLEX_CPP, 0);
+  sci_send(w, SCI_SETKEYWORDS, 0, (sptr_t)"int static");
+  sci_send(w, SCI_SETPHASESDRAW, SC_PHASES_ONE, 0);
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+
+  widget_paint(w, &f.c);
+  widget_paint(w, &f.c);
+  lines = widget_get_prop_int(w, CODE_EDIT_PROP_PAINTED_LINES, 0);
+
+  /*
+   * 单阶段绘制时先填充整行，每行的十几段文字都使用缺省背景色，绘制文字只去掉文字覆盖的部分，
+   * 后面各段的背景都不再填充，而不只是每行的第一段。
+   */
+  ASSERT_GT(lines, 0);
+  ASSERT_GT(widget_get_prop_int(w, CODE_EDIT_PROP_FILLS_ELIDED, 0), lines * 10);
+  ASSERT_LT(widget_get_prop_int(w, CODE_EDIT_PROP_FILL_RECTS, 0), lines * 3);
+
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, load_keeps_lexer) {
+  char value[8];
+  const char* filename = "code_edit_load_lexer_test.c";
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+
+  sci_send(w, SCI_SETLEXER, SCLEX_CPP, 0);
+  sci_send(w, SCI_SETPROPERTY, (uptr_t)"fold", (sptr_t)"1");
+  sci_send(w, SCI_SETKEYWORDS, 0, (sptr_t)"sum");
+  ASSERT_EQ(file_write(filename, "int sum;\n", 9), RET_OK);
+
+  /*加载文件后沿用原来的词法分析器、属性和关键字。*/
+  ASSERT_EQ(code_edit_load(w, filename), RET_OK);
+  ASSERT_EQ(sci_send(w, SCI_GETLEXER, 0, 0), SCLEX_CPP);
+  ASSERT_EQ(sci_send(w, SCI_GETPROPERTY, (uptr_t)"fold", (sptr_t)value), 1);
+  ASSERT_STREQ(value, "1");
+  sci_send(w, SCI_COLOURISE, 0, -1);
+  ASSERT_EQ(sci_send(w, SCI_GETSTYLEAT, 4, 0), SCE_C_WORD);
+
+  widget_destroy(w);
+  fs_remove_file(os_fs(), filename);
+}
+
+TEST(code_edit, save_stream) {
+  str_t str;
+  uint32_t size = 0;
+  char* data = NULL;
+  const char* filename = "code_edit_save_test.c";
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+  code_edit_t* code_edit = CODE_EDIT(w);
+
+  str_init(&str, 1024);
+  for (int i = 0; i < 10000; i++) {
+    str_append(&str, "static int sum(const int* a, int n) { return a[n - 1]; }\n");
+  }
+  ASSERT_EQ(widget_set_text_utf8(w, str.str), RET_OK);
+
+  /*在中间插入文本，让文档缓冲区的间隙位于文档中间。*/
+  ASSERT_EQ(code_edit_insert_text(w, str.size / 2, "/*gap*/"), RET_OK);
+  str_insert(&str, str.size / 2, "/*gap*/");
+  str_reset(&(code_edit->text));
+
+  ASSERT_EQ(code_edit_save(w, filename, TRUE), RET_OK);
+  ASSERT_EQ(code_edit->text.capacity, 0u);
+
+  data = (char*)file_read(filename, &size);
+  ASSERT_TRUE(data != NULL);
+  ASSERT_EQ(size, str.size + 3);
+  ASSERT_EQ(memcmp(data, "\xEF\xBB\xBF", 3), 0);
+  ASSERT_EQ(memcmp(data + 3, str.str, str.size), 0);
+  TKMEM_FREE(data);
+
+  widget_destroy(w);
+  fs_remove_file(os_fs(), filename);
+  str_reset(&str);
+}
+
+static ret_t on_text_changed(void* ctx, event_t* e) {
+  std::string* mirror = (std::string*)ctx;
+  code_edit_text_changed_event_t* evt = (code_edit_text_changed_event_t*)e;
+
+  if (evt->deleted_length < 0) {
+    *mirror = widget_get_prop_str(WIDGET(e->target), WIDGET_PROP_TEXT, "");
+  } else {
+    mirror->erase(evt->offset, evt->deleted_length);
+    mirror->insert(evt->offset, evt->inserted, evt->inserted_length);
+  }
+
+  return RET_OK;
+}
+
+TEST(code_edit, text_changed_event) {
+  std::string mirror;
+  const char* filename = "code_edit_text_changed_test.c";
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+
+  /*只根据增量事件维护的副本应始终与文档内容一致。*/
+  widget_on(w, EVT_CODE_EDIT_TEXT_CHANGED, on_text_changed, &mirror);
+  ASSERT_EQ(widget_set_text_utf8(w, "int a;\nint b;\n"), RET_OK);
+  ASSERT_EQ(mirror, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+
+  ASSERT_EQ(code_edit_insert_text(w, 4, "abc_"), RET_OK);
+  ASSERT_EQ(code_edit_insert_text(w, 0, "/*中文*/"), RET_OK);
+  ASSERT_EQ(mirror, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+
+  ASSERT_EQ(code_edit_select_all(w), RET_OK);
+  ASSERT_EQ(code_edit_clear(w), RET_OK);
+  ASSERT_EQ(mirror, "");
+
+  ASSERT_EQ(code_edit_undo(w), RET_OK);
+  ASSERT_EQ(mirror, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+  ASSERT_EQ(code_edit_undo(w), RET_OK);
+  ASSERT_EQ(code_edit_redo(w), RET_OK);
+  ASSERT_EQ(mirror, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+
+  /*加载文件替换整个文档，监听者重新获取全部文本。*/
+  ASSERT_EQ(file_write(filename, "int main() {}\n", 14), RET_OK);
+  ASSERT_EQ(code_edit_load(w, filename), RET_OK);
+  ASSERT_EQ(mirror, "int main() {}\n");
+
+  widget_destroy(w);
+  fs_remove_file(os_fs(), filename);
+}
+
+static ret_t on_blur_value_changed(void* ctx, event_t* e) {
+  std::vector<std::string>* values = (std::vector<std::string>*)ctx;
+  value_change_event_t* evt = (value_change_event_t*)e;
+
+  values->push_back(value_str(&(evt->new_value)));
+
+  return RET_OK;
+}
+
+static void dispatch_focus_event(widget_t* w, uint32_t type) {
+  event_t e = event_init(type, w);
+
+  widget_dispatch(w, &e);
+}
+
+TEST(code_edit, blur_value_changed) {
+  std::vector<std::string> values;
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+
+  ASSERT_EQ(widget_set_text_utf8(w, "int a;\n"), RET_OK);
+  dispatch_focus_event(w, EVT_FOCUS);
+  ASSERT_EQ(code_edit_insert_text(w, 0, "/*x*/"), RET_OK);
+
+  /*获得焦点后文本有变化，失去焦点时触发EVT_VALUE_CHANGED，new_value为全部文本。*/
+  widget_on(w, EVT_VALUE_CHANGED, on_blur_value_changed, &values);
+  dispatch_focus_event(w, EVT_BLUR);
+  ASSERT_EQ(values.size(), 1u);
+  ASSERT_EQ(values[0], "/*x*/int a;\n");
+
+  /*没有修改时不触发。*/
+  dispatch_focus_event(w, EVT_FOCUS);
+  dispatch_focus_event(w, EVT_BLUR);
+  ASSERT_EQ(values.size(), 1u);
+
+  widget_destroy(w);
+}
+
+TEST(code_edit, text_snapshot) {
+  str_t str;
+  uint32_t generation = 0;
+  const char* text = NULL;
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+
+  str_init(&str, 1024);
+  while (str.size < 1024 * 1024) {
+    str_append(&str, "static int sum(const int* a, int n) { return a[n - 1]; }\n");
+  }
+  ASSERT_EQ(widget_set_text_utf8(w, str.str), RET_OK);
+  generation = widget_get_prop_int(w, CODE_EDIT_PROP_GENERATION, 0);
+  ASSERT_GT(generation, 0u);
+
+  /*文档没有变化时返回同一个快照，不再复制。*/
+  text = widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL);
+  ASSERT_STREQ(text, str.str);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), text);
+  }
+  ASSERT_EQ(widget_get_prop_int(w, CODE_EDIT_PROP_GENERATION, 0), generation);
+
+  /*修改后版本号递增，快照随之更新。*/
+  ASSERT_EQ(code_edit_insert_text(w, 0, "//"), RET_OK);
+  ASSERT_GT((uint32_t)widget_get_prop_int(w, CODE_EDIT_PROP_GENERATION, 0), generation);
+  text = widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL);
+  ASSERT_EQ(strncmp(text, "//static", 8), 0);
+  ASSERT_EQ(strlen(text), str.size + 2);
+
+  generation = widget_get_prop_int(w, CODE_EDIT_PROP_GENERATION, 0);
+  ASSERT_EQ(code_edit_undo(w), RET_OK);
+  ASSERT_GT((uint32_t)widget_get_prop_int(w, CODE_EDIT_PROP_GENERATION, 0), generation);
+  ASSERT_STREQ(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), str.str);
+
+  ASSERT_EQ(widget_set_text_utf8(w, ""), RET_OK);
+  ASSERT_STREQ(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), "");
+
+  widget_destroy(w);
+  str_reset(&str);
+}
+
+TEST(code_edit, text_range) {
+  str_t str;
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+
+  str_init(&str, 0);
+  ASSERT_EQ(code_edit_get_line_count(w), 1u);
+  ASSERT_EQ(code_edit_get_line(w, 0, &str), RET_OK);
+  ASSERT_STREQ(str.str, "");
+
+  ASSERT_EQ(widget_set_text_utf8(w, "int a;\r\n\n中文 b;\nlast"), RET_OK);
+  ASSERT_EQ(code_edit_get_line_count(w), 4u);
+
+  ASSERT_EQ(code_edit_get_text_range(w, 4, 10, &str), RET_OK);
+  ASSERT_STREQ(str.str, "a;\r\n\n\xE4");
+  ASSERT_EQ(str.size, 6u);
+  ASSERT_EQ(code_edit_get_text_range(w, 19, 100, &str), RET_OK);
+  ASSERT_STREQ(str.str, "last");
+  ASSERT_EQ(code_edit_get_text_range(w, 100, 200, &str), RET_OK);
+  ASSERT_STREQ(str.str, "");
+
+  /*行的文本不包括换行符。*/
+  ASSERT_EQ(code_edit_get_line(w, 0, &str), RET_OK);
+  ASSERT_STREQ(str.str, "int a;");
+  ASSERT_EQ(code_edit_get_line(w, 1, &str), RET_OK);
+  ASSERT_STREQ(str.str, "");
+  ASSERT_EQ(code_edit_get_line(w, 2, &str), RET_OK);
+  ASSERT_STREQ(str.str, "中文 b;");
+  ASSERT_EQ(code_edit_get_line(w, 3, &str), RET_OK);
+  ASSERT_STREQ(str.str, "last");
+  ASSERT_NE(code_edit_get_line(w, 4, &str), RET_OK);
+
+  ASSERT_EQ(code_edit_offset_from_line(w, 0), 0);
+  ASSERT_EQ(code_edit_offset_from_line(w, 1), 8);
+  ASSERT_EQ(code_edit_offset_from_line(w, 2), 9);
+  ASSERT_EQ(code_edit_offset_from_line(w, 3), 19);
+  ASSERT_EQ(code_edit_offset_from_line(w, 4), 23);
+  ASSERT_EQ(code_edit_offset_from_line(w, 5), -1);
+
+  ASSERT_EQ(code_edit_line_from_offset(w, 0), 0u);
+  ASSERT_EQ(code_edit_line_from_offset(w, 7), 0u);
+  ASSERT_EQ(code_edit_line_from_offset(w, 8), 1u);
+  ASSERT_EQ(code_edit_line_from_offset(w, 20), 3u);
+  ASSERT_EQ(code_edit_line_from_offset(w, 1000), 3u);
+  ASSERT_EQ(code_edit_line_from_offset(w, 0xffffffff), 3u);
+
+  widget_destroy(w);
+  str_reset(&str);
+}
+
+static ret_t on_batch_value_changed(void* ctx, event_t* e) {
+  (*(int32_t*)ctx)++;
+
+  return RET_OK;
+}
+
+TEST(code_edit, batch) {
+  int32_t plain = 0;
+  int32_t batch = 0;
+  int32_t changed = 0;
+  std::string expected;
+  widget_t* w = code_edit_create(NULL, 10, 20, 300, 400);
+
+  code_edit_set_lang(w, "c");
+  for (int i = 0; i < 10000; i++) {
+    expected += "int a = 1;\n";
+  }
+
+  plain = widget_get_prop_int(w, CODE_EDIT_PROP_REDRAW_REQUESTS, 0);
+  for (int i = 0; i < 10000; i++) {
+    code_edit_insert_text(w, 0xffffffff, "int a = 1;\n");
+  }
+  plain = widget_get_prop_int(w, CODE_EDIT_PROP_REDRAW_REQUESTS, 0) - plain;
+  ASSERT_EQ(expected, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+
+  /*批量插入只在结束时移动光标、更新滚动条和重绘(重绘请求次数与插入次数无关)，
+   *只触发一次EVT_VALUE_CHANGED，并且一次撤销全部插入。*/
+  ASSERT_EQ(widget_set_text_utf8(w, "/*head*/\n"), RET_OK);
+  code_edit_set_lang(w, "c");
+  widget_on(w, EVT_VALUE_CHANGED, on_batch_value_changed, &changed);
+  batch = widget_get_prop_int(w, CODE_EDIT_PROP_REDRAW_REQUESTS, 0);
+  ASSERT_EQ(code_edit_begin_batch(w), RET_OK);
+  for (int i = 0; i < 10000; i++) {
+    code_edit_insert_text(w, 0xffffffff, "int a = 1;\n");
+  }
+  ASSERT_EQ(code_edit_end_batch(w), RET_OK);
+  batch = widget_get_prop_int(w, CODE_EDIT_PROP_REDRAW_REQUESTS, 0) - batch;
+
+  ASSERT_GE(plain, 10000);
+  ASSERT_LE(batch, 8);
+  ASSERT_EQ(changed, 1);
+  ASSERT_EQ("/*head*/\n" + expected, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+
+  ASSERT_EQ(code_edit_undo(w), RET_OK);
+  ASSERT_STREQ(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), "/*head*/\n");
+
+  /*嵌套的批量修改在最外层结束时才提交。*/
+  changed = 0;
+  ASSERT_EQ(code_edit_begin_batch(w), RET_OK);
+  ASSERT_EQ(code_edit_begin_batch(w), RET_OK);
+  ASSERT_EQ(code_edit_insert_text(w, 0, "a"), RET_OK);
+  ASSERT_EQ(code_edit_end_batch(w), RET_OK);
+  ASSERT_EQ(code_edit_insert_text(w, 0, "b"), RET_OK);
+  ASSERT_EQ(changed, 0);
+  ASSERT_EQ(code_edit_end_batch(w), RET_OK);
+  ASSERT_EQ(changed, 1);
+  ASSERT_EQ(code_edit_undo(w), RET_OK);
+  ASSERT_STREQ(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), "/*head*/\n");
+
+  widget_destroy(w);
+}
+
+static ret_t on_update_text_changed(void* ctx, event_t* e) {
+  int32_t* stat = (int32_t*)ctx;
+  code_edit_text_changed_event_t* evt = (code_edit_text_changed_event_t*)e;
+
+  stat[0]++;
+  stat[1] += evt->deleted_length + evt->inserted_length;
+
+  return RET_OK;
+}
+
+TEST(code_edit, update_text) {
+  std::string text;
+  std::string next;
+  int32_t stat[2] = {0, 0};
+  widget_t* w = code_edit_create(NULL, 10, 20, 300, 400);
+
+  for (int i = 0; i < 20000; i++) {
+    char line[64];
+    tk_snprintf(line, sizeof(line), "int v%d = %d;\n", i, i);
+    text += line;
+  }
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+  widget_on(w, EVT_CODE_EDIT_TEXT_CHANGED, on_update_text_changed, stat);
+
+  /*只修改一行时，只有这一行被替换。*/
+  next = text;
+  next.replace(next.find("int v10000 = 10000;"), 19, "long v10000 = 1;");
+  ASSERT_EQ(code_edit_update_text(w, next.c_str()), RET_OK);
+  ASSERT_EQ(next, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+  ASSERT_EQ(stat[0], 2);
+  ASSERT_LT(stat[1], 64);
+
+  /*内容相同时不修改文档。*/
+  stat[0] = 0;
+  ASSERT_EQ(code_edit_update_text(w, next.c_str()), RET_OK);
+  ASSERT_EQ(stat[0], 0);
+
+  /*所有修改一次撤销。*/
+  ASSERT_EQ(code_edit_undo(w), RET_OK);
+  ASSERT_EQ(text, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+
+  /*随机增删改多处，结果与新文本一致。*/
+  srand(1234);
+  for (int round = 0; round < 50; round++) {
+    std::string lines[200];
+    std::string from;
+    std::string to;
+    int n = rand() % 200;
+    for (int i = 0; i < n; i++) {
+      lines[i] = std::string(1, 'a' + rand() % 4) + (rand() % 3 ? "\n" : "\r\n");
+      from += lines[i];
+    }
+    for (int i = 0; i < n; i++) {
+      int op = rand() % 6;
+      if (op == 0) {
+        continue;
+      } else if (op == 1) {
+        to += "x\n";
+      } else if (op == 2) {
+        to += "y\n" + lines[i];
+      } else {
+        to += lines[i];
+      }
+    }
+    if (rand() % 2) {
+      to += "tail";
+    }
+    ASSERT_EQ(widget_set_text_utf8(w, from.c_str()), RET_OK);
+    ASSERT_EQ(code_edit_update_text(w, to.c_str()), RET_OK);
+    ASSERT_EQ(to, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+    ASSERT_EQ(code_edit_undo(w), RET_OK);
+    ASSERT_EQ(from, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+  }
+
+  /*差异太多时整体替换中间不同的部分。*/
+  next.clear();
+  for (int i = 0; i < 2000; i++) {
+    next += (i % 2) ? "odd\n" : "even\n";
+  }
+  ASSERT_EQ(code_edit_update_text(w, next.c_str()), RET_OK);
+  ASSERT_EQ(next, widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL));
+
+  ASSERT_EQ(code_edit_replace_text(w, 0, 4, "EVEN"), RET_OK);
+  ASSERT_EQ(code_edit_replace_text(w, 5, 9, ""), RET_OK);
+  ASSERT_EQ(strncmp(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), "EVEN\neven\nodd\n", 14), 0);
+  ASSERT_EQ(code_edit_undo(w), RET_OK);
+  ASSERT_EQ(strncmp(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), "EVEN\nodd\n", 9), 0);
+
+  widget_destroy(w);
+}
+
+TEST(code_edit, background_lexing) {
+  std::string text;
+  int32_t length = 0;
+  widget_t* w = code_edit_create(NULL, 10, 20, 300, 400);
+  widget_t* sync = code_edit_create(NULL, 10, 20, 300, 400);
+
+  for (int i = 0; i < 20000; i++) {
+    text += "/* block\n * comment */\nstatic const char* s = \"str\"; // tail\n#define X 1\n";
+  }
+  length = text.size();
+
+  /*测试中没有主题资源，直接设置词法分析器。*/
+  sci_send(sync, SCI_SETLEXER, SCLEX_CPP, 0);
+  ASSERT_EQ(widget_set_text_utf8(sync, text.c_str()), RET_OK);
+  sci_send(sync, SCI_COLOURISE, 0, -1);
+  ASSERT_EQ(sci_send(sync, SCI_GETENDSTYLED, 0, 0), length);
+
+  /*后台完成整个文档的分析，期间UI线程只做快照和合并。*/
+  sci_send(w, SCI_SETLEXER, SCLEX_CPP, 0);
+  ASSERT_EQ(code_edit_set_background_lexing(w, TRUE), RET_OK);
+  ASSERT_EQ(widget_get_prop_bool(w, CODE_EDIT_PROP_BACKGROUND_LEXING, FALSE), TRUE);
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+  ASSERT_LT(sci_send(w, SCI_GETENDSTYLED, 0, 0), length);
+  while (sci_send(w, SCI_GETENDSTYLED, 0, 0) < length) {
+    idle_dispatch();
+    sleep_ms(1);
+  }
+
+  /*结果与UI线程中的同步分析一致。*/
+  for (int32_t i = 0; i < length; i += 7) {
+    ASSERT_EQ(sci_send(w, SCI_GETSTYLEAT, i, 0), sci_send(sync, SCI_GETSTYLEAT, i, 0));
+  }
+  for (int32_t i = 0; i < 80000; i += 13) {
+    ASSERT_EQ(sci_send(w, SCI_GETLINESTATE, i, 0), sci_send(sync, SCI_GETLINESTATE, i, 0));
+  }
+
+  /*分析期间文档被修改，结果作废，不会覆盖新的内容。*/
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+  idle_dispatch();
+  ASSERT_EQ(code_edit_insert_text(w, 0, "\"unterminated\n"), RET_OK);
+  for (int i = 0; i < 100; i++) {
+    idle_dispatch();
+    sleep_ms(1);
+  }
+  ASSERT_LT(sci_send(w, SCI_GETENDSTYLED, 0, 0), length);
+
+  /*销毁时取消正在进行的任务。*/
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+  idle_dispatch();
+  widget_destroy(w);
+  widget_destroy(sync);
+}
+
+typedef struct _styling_stats_t {
+  uint32_t paint_events;
+  uint32_t idle_events;
+  uint32_t lines;
+  uint32_t max_lines;
+  uint64_t duration_us;
+  int32_t end_styled;
+} styling_stats_t;
+
+static ret_t on_styling(void* ctx, event_t* e) {
+  styling_stats_t* stats = (styling_stats_t*)ctx;
+  code_edit_styling_event_t* evt = (code_edit_styling_event_t*)e;
+
+  if (evt->idle) {
+    stats->idle_events++;
+  } else {
+    stats->paint_events++;
+  }
+  stats->lines += evt->lines;
+  stats->max_lines = tk_max(stats->max_lines, evt->lines);
+  stats->duration_us += evt->duration_us;
+  stats->end_styled = evt->end_styled;
+
+  return RET_OK;
+}
+
+TEST(code_edit, idle_styling) {
+  paint_fixture_t f;
+  styling_stats_t stats;
+  widget_t* w = paint_fixture_init(&f);
+  std::string text = repeat_text(
+      "/* block\n * comment */\nstatic const char* s = \"str\"; // tail\n#define X 1\n", 5000);
+  int32_t length = text.size();
+
+  sci_send(w, SCI_SETLEXER, SCLEX_CPP, 0);
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+  widget_on(w, EVT_CODE_EDIT_STYLING, on_styling, &stats);
+
+  /*默认策略：绘制时只分析可见部分，空闲时不分析。*/
+  memset(&stats, 0x00, sizeof(stats));
+  widget_paint(w, &f.c);
+  idle_dispatch();
+  ASSERT_EQ(stats.paint_events, 1u);
+  ASSERT_EQ(stats.idle_events, 0u);
+  ASSERT_GT(stats.lines, 0u);
+  ASSERT_LT(stats.end_styled, length);
+
+  /*all：空闲时按预算分多次分析到文档末尾。*/
+  ASSERT_EQ(widget_set_prop_int(w, CODE_EDIT_PROP_IDLE_STYLING, SC_IDLESTYLING_ALL), RET_OK);
+  ASSERT_EQ(widget_set_prop_int(w, CODE_EDIT_PROP_STYLING_BUDGET_US, 200), RET_OK);
+  ASSERT_EQ(widget_get_prop_int(w, CODE_EDIT_PROP_IDLE_STYLING, 0), SC_IDLESTYLING_ALL);
+  ASSERT_EQ(widget_get_prop_int(w, CODE_EDIT_PROP_STYLING_BUDGET_US, 0), 200);
+  ASSERT_EQ(sci_send(w, SCI_GETIDLESTYLING, 0, 0), SC_IDLESTYLING_ALL);
+  ASSERT_NE(code_edit_set_idle_styling(w, SC_IDLESTYLING_ALL + 1), RET_OK);
+
+  memset(&stats, 0x00, sizeof(stats));
+  code_edit_insert_text(w, 0, " ");
+  widget_paint(w, &f.c);
+  for (int i = 0; i < 100000 && sci_send(w, SCI_GETENDSTYLED, 0, 0) <= length; i++) {
+    idle_dispatch();
+  }
+  ASSERT_EQ(sci_send(w, SCI_GETENDSTYLED, 0, 0), length + 1);
+  ASSERT_EQ(stats.end_styled, length + 1);
+  ASSERT_GT(stats.idle_events, 1u);
+  ASSERT_LT(stats.max_lines, 20000u);
+
+  /*全部分析完后不再有空闲任务。*/
+  memset(&stats, 0x00, sizeof(stats));
+  idle_dispatch();
+  ASSERT_EQ(stats.idle_events, 0u);
+
+  paint_fixture_deinit(&f);
+}
+
+/*与同步分析的结果比较样式，打开折叠时也比较折叠级别。*/
+static void check_same_styles(widget_t* w, const std::string& text, int lexer = SCLEX_CPP) {
+  widget_t* sync = code_edit_create(NULL, 0, 0, 300, 200);
+  int32_t length = text.size();
+  int32_t lines = 0;
+
+  sci_send(sync, SCI_SETLEXER, lexer, 0);
+  if (sci_send(w, SCI_GETPROPERTYINT, (uptr_t)"fold", 0)) {
+    sci_send(sync, SCI_SETPROPERTY, (uptr_t)"fold", (sptr_t)"1");
+  }
+  ASSERT_EQ(widget_set_text_utf8(sync, text.c_str()), RET_OK);
+  sci_send(sync, SCI_COLOURISE, 0, -1);
+  /*已经分析到末尾时不再调用SCI_COLOURISE，以免从上次提前结束的位置补分析时掩盖错误。*/
+  if (sci_send(w, SCI_GETENDSTYLED, 0, 0) < length) {
+    sci_send(w, SCI_COLOURISE, sci_send(w, SCI_GETENDSTYLED, 0, 0), -1);
+  }
+  for (int32_t i = 0; i < length; i++) {
+    ASSERT_EQ(sci_send(w, SCI_GETSTYLEAT, i, 0), sci_send(sync, SCI_GETSTYLEAT, i, 0)) << i;
+  }
+
+  lines = sci_send(sync, SCI_GETLINECOUNT, 0, 0);
+  for (int32_t i = 0; i < lines; i++) {
+    ASSERT_EQ(sci_send(w, SCI_GETFOLDLEVEL, i, 0), sci_send(sync, SCI_GETFOLDLEVEL, i, 0)) << i;
+  }
+
+  widget_destroy(sync);
+}
+
+static std::string get_all_text(widget_t* w) {
+  str_t str;
+  std::string text;
+
+  str_init(&str, 0);
+  code_edit_get_text_range(w, 0, 0xffffffff, &str);
+  text.assign(str.str, str.size);
+  str_reset(&str);
+
+  return text;
+}
+
+TEST(code_edit, lex_checkpoint) {
+  std::string text;
+  paint_fixture_t f;
+  styling_stats_t stats;
+  widget_t* w = paint_fixture_init(&f);
+  const char* keys = "int x = 1;";
+  int32_t line = 0;
+  int32_t offset = 0;
+  int32_t length = 0;
+
+  text += "#define FEATURE 0\n";
+  text += repeat_text(
+      "static int func(int a) {\n  /* add */\n  int b = a + 1;\n"
+      "  const char* s = \"str\";\n  return b; // done\n}\n\n"
+      "#if FEATURE\nint feature(void);\n#endif\n",
+      10000);
+  length = text.size();
+
+  sci_send(w, SCI_SETLEXER, SCLEX_CPP, 0);
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+  sci_send(w, SCI_COLOURISE, 0, -1);
+  ASSERT_EQ(sci_send(w, SCI_GETENDSTYLED, 0, 0), length);
+  widget_on(w, EVT_CODE_EDIT_STYLING, on_styling, &stats);
+
+  /*在文件中间的函数里输入，每次按键只重新分析几行，其余部分沿用原来的样式。*/
+  line = code_edit_get_line_count(w) / 2 + 3;
+  offset = code_edit_offset_from_line(w, line);
+  sci_send(w, SCI_SETFIRSTVISIBLELINE, line - 5, 0);
+  for (const char* k = keys; *k; k++) {
+    char key[2] = {*k, '\0'};
+    memset(&stats, 0x00, sizeof(stats));
+    ASSERT_EQ(code_edit_insert_text(w, offset++, key), RET_OK);
+    widget_paint(w, &f.c);
+    ASSERT_GT(stats.lines, 0u);
+    ASSERT_LE(stats.lines, 8u);
+    ASSERT_EQ(sci_send(w, SCI_GETENDSTYLED, 0, 0), sci_send(w, SCI_GETLENGTH, 0, 0));
+  }
+
+  /*在后面未分析过的#if块中输入时，先从上次停止的位置补上词法分析器内部的状态。*/
+  line += 25;
+  sci_send(w, SCI_SETFIRSTVISIBLELINE, line - 5, 0);
+  ASSERT_EQ(code_edit_insert_text(w, code_edit_offset_from_line(w, line), "x"), RET_OK);
+  widget_paint(w, &f.c);
+  check_same_styles(w, get_all_text(w));
+
+  /*插入没有结束的#if 0后，后面的状态都与原来不同，不能提前结束。*/
+  ASSERT_EQ(code_edit_insert_text(w, code_edit_offset_from_line(w, line - 20), "#if 0\n"), RET_OK);
+  widget_paint(w, &f.c);
+  ASSERT_LT(sci_send(w, SCI_GETENDSTYLED, 0, 0), sci_send(w, SCI_GETLENGTH, 0, 0));
+  check_same_styles(w, get_all_text(w));
+
+  /*撤销后恢复原来的样式。*/
+  sci_send(w, SCI_UNDO, 0, 0);
+  widget_paint(w, &f.c);
+  check_same_styles(w, get_all_text(w));
+
+  /*修改宏定义会影响后面所有的#if，不能提前结束。*/
+  sci_send(w, SCI_SETFIRSTVISIBLELINE, 0, 0);
+  ASSERT_EQ(code_edit_replace_text(w, 16, 17, "1"), RET_OK);
+  widget_paint(w, &f.c);
+  ASSERT_LT(sci_send(w, SCI_GETENDSTYLED, 0, 0), sci_send(w, SCI_GETLENGTH, 0, 0));
+  check_same_styles(w, get_all_text(w));
+
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, lex_checkpoint_lines) {
+  paint_fixture_t f;
+  widget_t* w = paint_fixture_init(&f);
+  std::string text =
+      repeat_text("diff a b\n--- a --- b\n+++ b\n@@ -1 +1 @@\n-x\n+y\n", 5000);
+  int32_t line = 0;
+
+  sci_send(w, SCI_SETLEXER, SCLEX_DIFF, 0);
+  sci_send(w, SCI_SETPROPERTY, (uptr_t)"fold", (sptr_t)"1");
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+  sci_send(w, SCI_COLOURISE, 0, -1);
+
+  /*
+   * 在"--- a --- b"中间粘贴以换行结尾的多行文本，拆出的"--- b"行的行状态和折叠级别是从下一行
+   * "+++ b"复制来的，重新分析后恰好相同，但实际还要被下一行清除折叠头标志，不能据此判断收敛。
+   */
+  line = code_edit_get_line_count(w) / 2 + 1;
+  sci_send(w, SCI_SETFIRSTVISIBLELINE, line - 5, 0);
+  ASSERT_EQ(code_edit_insert_text(w, code_edit_offset_from_line(w, line) + 6, "\n+z\n"), RET_OK);
+  widget_paint(w, &f.c);
+  check_same_styles(w, get_all_text(w), SCLEX_DIFF);
+
+  /*从"+++ b"行首删除多行后，合并的行也是如此。*/
+  line += 9;
+  sci_send(w, SCI_SETFIRSTVISIBLELINE, line - 5, 0);
+  ASSERT_EQ(code_edit_replace_text(w, code_edit_offset_from_line(w, line),
+                                   code_edit_offset_from_line(w, line + 5), ""),
+            RET_OK);
+  widget_paint(w, &f.c);
+  check_same_styles(w, get_all_text(w), SCLEX_DIFF);
+
+  /*撤销后恢复原来的样式和折叠级别。*/
+  sci_send(w, SCI_UNDO, 0, 0);
+  widget_paint(w, &f.c);
+  check_same_styles(w, get_all_text(w), SCLEX_DIFF);
+
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, background_lexing_edit) {
+  std::string text;
+  paint_fixture_t f;
+  widget_t* w = paint_fixture_init(&f);
+  int32_t line = 0;
+  int32_t length = 0;
+
+  text += repeat_text("static int a = 1; /* tail */\n", 5000);
+  text += "#if 0\n";
+  text += repeat_text("int hidden(void);\n", 2000);
+  text += "#endif\n";
+  text += repeat_text("static int b = 2; // tail\n", 5000);
+  length = text.size();
+
+  sci_send(w, SCI_SETLEXER, SCLEX_CPP, 0);
+  ASSERT_EQ(code_edit_set_background_lexing(w, TRUE), RET_OK);
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+  widget_paint(w, &f.c);
+  while (sci_send(w, SCI_GETENDSTYLED, 0, 0) < length) {
+    idle_dispatch();
+    sleep_ms(1);
+  }
+
+  /*
+   * 刚合并完就在后面的#if 0块中输入：UI线程的词法分析器没有分析过这些文本，先补上自己的
+   * 预处理状态，结果与同步分析一致。
+   */
+  line = 5000 + 1000;
+  sci_send(w, SCI_SETFIRSTVISIBLELINE, line - 5, 0);
+  ASSERT_EQ(code_edit_insert_text(w, code_edit_offset_from_line(w, line), "x"), RET_OK);
+  widget_paint(w, &f.c);
+  check_same_styles(w, get_all_text(w));
+
+  /*空闲时补完状态后再修改，结果同样一致。*/
+  ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+  widget_paint(w, &f.c);
+  while (sci_send(w, SCI_GETENDSTYLED, 0, 0) < length) {
+    idle_dispatch();
+    sleep_ms(1);
+  }
+  for (int i = 0; i < 100; i++) {
+    idle_dispatch();
+  }
+  sci_send(w, SCI_SETFIRSTVISIBLELINE, line - 5, 0);
+  ASSERT_EQ(code_edit_insert_text(w, code_edit_offset_from_line(w, line), "y"), RET_OK);
+  widget_paint(w, &f.c);
+  check_same_styles(w, get_all_text(w));
+
+  paint_fixture_deinit(&f);
+}
+
+static std::string utf8_range(uint32_t first, uint32_t last) {
+  std::string text;
+
+  /*只用于U+0800到U+FFFF之间的字符，都是3个字节。*/
+  for (uint32_t c = first; c <= last; c++) {
+    text += (char)(0xE0 | (c >> 12));
+    text += (char)(0x80 | ((c >> 6) & 0x3F));
+    text += (char)(0x80 | (c & 0x3F));
+    text += ' ';
+  }
+
+  return text;
+}
+
+TEST(code_edit, lexer_non_ascii) {
+  /*
+   * LexModula和LexTADS3曾经把码点传给isalpha，认为是单词开头的汉字又不会被单词扫描消耗，
+   * 分析停在同一个位置不再前进。isalpha对这些码点的结果取决于C库，所以覆盖一段连续的汉字。
+   */
+  std::string chars = utf8_range(0x4E00, 0x4FFF);
+  std::string modula = "(* comment *)\nMODULE Stack;\nBEGIN\n  " + chars +
+                       "\n  WriteString(\"" + chars + "\")\nEND Stack.\n";
+  std::string tads3 = "#include <adv3.h>\nstartRoom: Room 'Hall' 'the hall'\n    \"A hall. \"\n;\n" +
+                      chars + "\nmodify Thing\n    describe() { say('" + chars + "' + name); }\n;\n";
+  static const int s_lexers[] = {SCLEX_MODULA, SCLEX_TADS3};
+  const std::string* texts[] = {&modula, &tads3};
+  widget_t* w = code_edit_create(NULL, 10, 20, 300, 400);
+
+  for (size_t i = 0; i < ARRAY_SIZE(s_lexers); i++) {
+    sci_send(w, SCI_SETLEXER, s_lexers[i], 0);
+    ASSERT_EQ(widget_set_text_utf8(w, texts[i]->c_str()), RET_OK);
+    sci_send(w, SCI_COLOURISE, 0, -1);
+    ASSERT_EQ(sci_send(w, SCI_GETENDSTYLED, 0, 0), (sptr_t)texts[i]->size());
+  }
+
+  widget_destroy(w);
+}
+
+TEST(code_edit, lexer_range_end) {
+  /*字符串或标识符以反斜杠结束时，LexMaxima曾经把范围之后的一个字符也设置了样式。*/
+  static const char* s_cases[] = {"s: \"ab\\", "a: b\\"};
+  widget_t* w = code_edit_create(NULL, 10, 20, 300, 400);
+
+  sci_send(w, SCI_SETLEXER, SCLEX_MAXIMA, 0);
+  for (size_t i = 0; i < ARRAY_SIZE(s_cases); i++) {
+    std::string text = std::string(s_cases[i]) + "c;\n";
+    int32_t end = strlen(s_cases[i]);
+
+    ASSERT_EQ(widget_set_text_utf8(w, text.c_str()), RET_OK);
+    sci_send(w, SCI_COLOURISE, 0, end);
+    ASSERT_EQ(sci_send(w, SCI_GETENDSTYLED, 0, 0), end);
+
+    /*在文档末尾结束时也不能越界。*/
+    ASSERT_EQ(widget_set_text_utf8(w, s_cases[i]), RET_OK);
+    sci_send(w, SCI_COLOURISE, 0, -1);
+    ASSERT_EQ(sci_send(w, SCI_GETENDSTYLED, 0, 0), end);
+  }
+
+  widget_destroy(w);
+}
@@ -0,0 +1,118 @@
+﻿/*runTest和memTest共用的头文件和辅助函数。*/
+#ifndef CODE_EDIT_TEST_HELPER_H
+#define CODE_EDIT_TEST_HELPER_H
+
+#include "code_edit/code_edit.h"
+#include "lcd/lcd_mem_rgba8888.h"
+#include "tkc/fs.h"
+#include "tkc/platform.h"
+#include "tkc/time_now.h"
+#include "base/idle.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+
+/*直接访问ScintillaAWTK，用于检查样式等没有公开的状态。*/
+#include "Platform.h"
+#include "ILoader.h"
+#include "ILexer.h"
+#include "Scintilla.h"
+#include "SciLexer.h"
+#include "CharacterCategory.h"
+#include "Position.h"
+#include "UniqueString.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "ContractionState.h"
+#include "CellBuffer.h"
+#include "CallTip.h"
+#include "KeyMap.h"
+#include "Indicator.h"
+#include "LineMarker.h"
+#include "Style.h"
+#include "ViewStyle.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "Selection.h"
+#include "PositionCache.h"
+#include "EditModel.h"
+#include "MarginView.h"
+#include "EditView.h"
+#include "Editor.h"
+#include "AutoComplete.h"
+#include "ScintillaBase.h"
+#include "scintilla/awtk/ScintillaAWTK.h"
+
+using Scintilla::ScintillaAWTK;
+
+static inline sptr_t sci_send(widget_t* w, unsigned int msg, uptr_t wparam, sptr_t lparam) {
+  ScintillaAWTK* impl = static_cast<ScintillaAWTK*>(CODE_EDIT(w)->impl);
+  return impl->DefWndProc(msg, wparam, lparam);
+}
+
+/*绘制测试共用的画布和编辑器：画布和编辑器都是300x200，裁剪区为整个画布。*/
+typedef struct _paint_fixture_t {
+  lcd_t* lcd;
+  canvas_t c;
+  widget_t* w;
+} paint_fixture_t;
+
+static inline widget_t* paint_fixture_init(paint_fixture_t* f) {
+  rect_t r = rect_init(0, 0, 300, 200);
+
+  f->lcd = lcd_mem_rgba8888_create(r.w, r.h, TRUE);
+  canvas_init(&(f->c), f->lcd, font_manager());
+  canvas_set_clip_rect(&(f->c), &r);
+  f->w = code_edit_create(NULL, r.x, r.y, r.w, r.h);
+  widget_move_resize(f->w, r.x, r.y, r.w, r.h);
+
+  return f->w;
+}
+
+static inline ret_t paint_fixture_paint(paint_fixture_t* f, xy_t x, xy_t y, wh_t w, wh_t h) {
+  rect_t r = rect_init(x, y, w, h);
+
+  canvas_set_clip_rect(&(f->c), &r);
+
+  return widget_paint(f->w, &(f->c));
+}
+
+static inline void paint_fixture_deinit(paint_fixture_t* f) {
+  widget_destroy(f->w);
+  canvas_reset(&(f->c));
+  lcd_destroy(f->lcd);
+}
+
+static inline std::string repeat_text(const char* text, uint32_t times) {
+  std::string result;
+
+  for (uint32_t i = 0; i < times; i++) {
+    result += text;
+  }
+
+  return result;
+}
+
+static inline ret_t on_async_load_event(void* ctx, event_t* e) {
+  int32_t* events = (int32_t*)ctx;
+
+  if (e->type == EVT_PROGRESS) {
+    events[0]++;
+    events[1] = ((progress_event_t*)e)->percent;
+  } else if (e->type == EVT_DONE) {
+    events[2]++;
+  } else if (e->type == EVT_ERROR) {
+    events[3]++;
+  }
+
+  return RET_OK;
+}
+
+#endif /*CODE_EDIT_TEST_HELPER_H*/
@@ -0,0 +1,460 @@
+﻿#include "../code_edit_test_helper.h"
+#include <new>
+#include <atomic>
+#ifndef WIN32
+#include <sys/stat.h>
+#endif /*WIN32*/
+
+/*
+ * 替换全局的operator new/delete和glibc的malloc/calloc/realloc，统计绘制过程中的堆分配次数、
+ * 加载文件时的内存峰值以及每个线程累计分配的字节数，并用几MB到十几MB的文件检查加载、保存和
+ * 并行分析。这些用例单独编译成memTest，runTest仍使用默认的分配器。
+ * s_count_new是线程局部的，只统计打开它的线程，不与工作线程的分配竞争。
+ */
+static thread_local bool s_count_new = false;
+static uint32_t s_new_count = 0;
+static uint32_t s_malloc_count = 0;
+static std::atomic<size_t> s_new_bytes(0);
+static std::atomic<size_t> s_new_peak(0);
+static thread_local size_t s_thread_new_bytes = 0;
+
+#define NEW_HEADER_SIZE 16
+
+void* operator new(size_t size) {
+  char* p = NULL;
+
+  if (s_count_new) {
+    s_new_count++;
+  }
+
+  p = (char*)malloc(size + NEW_HEADER_SIZE);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+
+  *(size_t*)p = size;
+  s_thread_new_bytes += size;
+  size_t bytes = (s_new_bytes += size);
+  if (bytes > s_new_peak) {
+    s_new_peak = bytes;
+  }
+
+  return p + NEW_HEADER_SIZE;
+}
+
+void operator delete(void* p) noexcept {
+  if (p != NULL) {
+    char* h = (char*)p - NEW_HEADER_SIZE;
+    s_new_bytes -= *(size_t*)h;
+    free(h);
+  }
+}
+
+void operator delete(void* p, size_t size) noexcept {
+  operator delete(p);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return operator new(size);
+  } catch (...) {
+    return NULL;
+  }
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete[](void* p) noexcept {
+  operator delete(p);
+}
+
+void operator delete[](void* p, size_t size) noexcept {
+  operator delete(p);
+}
+
+#if defined(__GLIBC__)
+/*glibc下同时统计malloc/calloc/realloc，覆盖TKMEM_ALLOC等C接口的分配。*/
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+
+extern "C" void* malloc(size_t size) {
+  if (s_count_new) {
+    s_malloc_count++;
+  }
+
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t n, size_t size) {
+  if (s_count_new) {
+    s_malloc_count++;
+  }
+
+  return __libc_calloc(n, size);
+}
+
+extern "C" void* realloc(void* p, size_t size) {
+  if (s_count_new) {
+    s_malloc_count++;
+  }
+
+  return __libc_realloc(p, size);
+}
+#endif /*__GLIBC__*/
+
+TEST(code_edit, paint_no_alloc) {
+  paint_fixture_t f;
+  widget_t* w = paint_fixture_init(&f);
+
+  ASSERT_EQ(widget_set_text_utf8(w, repeat_text("int a = 0; /*comment*/\n", 100).c_str()), RET_OK);
+
+  /*前两帧完成布局和缓存，之后的稳态绘制不应再分配内存。*/
+  widget_paint(w, &f.c);
+  widget_paint(w, &f.c);
+
+  s_new_count = 0;
+  s_malloc_count = 0;
+  s_count_new = true;
+  widget_paint(w, &f.c);
+  s_count_new = false;
+  ASSERT_EQ(s_new_count, 0u);
+  ASSERT_EQ(s_malloc_count, 0u);
+
+  paint_fixture_deinit(&f);
+}
+
+TEST(code_edit, load_stream) {
+  str_t str;
+  size_t base = 0;
+  size_t peak = 0;
+  int32_t size = 0;
+  const char* filename = "code_edit_load_test.c";
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+
+  str_init(&str, 1024);
+  str_append(&str, "\xEF\xBB\xBF");
+  for (int i = 0; i < 40000; i++) {
+    str_append(&str, "static int sum(const int* a, int n) { return a[n - 1]; }\n");
+  }
+  ASSERT_EQ(file_write(filename, str.str, str.size), RET_OK);
+  size = str.size;
+
+  base = s_new_bytes;
+  s_new_peak = s_new_bytes.load();
+  ASSERT_EQ(code_edit_load(w, filename), RET_OK);
+  peak = s_new_peak - base;
+
+  /*文档的文本和样式各占一份文件大小，加上行索引，不再有整个文件的临时副本。*/
+  ASSERT_LT(peak, (size_t)size * 2 + size / 4);
+
+  ASSERT_EQ(code_edit_is_modified(w), FALSE);
+  ASSERT_EQ(strlen(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL)), size - 3);
+  ASSERT_EQ(strncmp(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), str.str + 3, 64), 0);
+
+  widget_destroy(w);
+  fs_remove_file(os_fs(), filename);
+  str_reset(&str);
+}
+
+TEST(code_edit, load_async) {
+  str_t str;
+  size_t ui_bytes = 0;
+  int32_t events[4] = {0, -1, 0, 0};
+  const char* filename = "code_edit_load_async_test.c";
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+
+  str_init(&str, 1024);
+  while (str.size < 16 * 1024 * 1024) {
+    str_append(&str, "static int sum(const int* a, int n) { return a[n - 1]; }\n");
+  }
+  ASSERT_EQ(file_write(filename, str.str, str.size), RET_OK);
+
+  widget_on(w, EVT_PROGRESS, on_async_load_event, events);
+  widget_on(w, EVT_DONE, on_async_load_event, events);
+  widget_on(w, EVT_ERROR, on_async_load_event, events);
+
+  /*加载期间UI线程照常处理idle，读取文件和分配文本都在工作线程中，UI线程只交换文档。
+   *阻塞时间见editorBench的load_async。*/
+  ui_bytes = s_thread_new_bytes;
+  ASSERT_EQ(code_edit_load_async(w, filename), RET_OK);
+  ASSERT_EQ(code_edit_is_loading(w), TRUE);
+
+  while (events[2] == 0 && events[3] == 0) {
+    idle_dispatch();
+    sleep_ms(1);
+  }
+  ui_bytes = s_thread_new_bytes - ui_bytes;
+
+  ASSERT_EQ(events[2], 1);
+  ASSERT_EQ(events[1], 100);
+  ASSERT_GT(events[0], 1);
+  ASSERT_LT(ui_bytes, str.size / 16);
+  ASSERT_EQ(code_edit_is_loading(w), FALSE);
+  ASSERT_EQ(strlen(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL)), str.size);
+
+  /*取消后当前文档保持不变，也不会再触发事件。*/
+  events[2] = 0;
+  ASSERT_EQ(widget_set_text_utf8(w, "int a;"), RET_OK);
+  ASSERT_EQ(code_edit_load_async(w, filename), RET_OK);
+  ASSERT_EQ(code_edit_cancel_load(w), RET_OK);
+  ASSERT_EQ(code_edit_is_loading(w), FALSE);
+  idle_dispatch();
+  ASSERT_EQ(events[2], 0);
+  ASSERT_STREQ(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), "int a;");
+
+  ASSERT_EQ(code_edit_load_async(w, filename), RET_OK);
+  widget_destroy(w);
+  fs_remove_file(os_fs(), filename);
+  str_reset(&str);
+}
+
+TEST(code_edit, load_mapped) {
+  str_t str;
+  size_t base = 0;
+  size_t peak = 0;
+  int32_t lines = 0;
+  int32_t events[4] = {0, -1, 0, 0};
+  const char* filename = "code_edit_load_mapped_test.log";
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+
+  str_init(&str, 1024);
+  while (str.size < 8 * 1024 * 1024) {
+    str_append(&str, (lines % 2) ? "INFO  request done in 12ms\r\n" : "DEBUG idle\n");
+    lines++;
+  }
+  ASSERT_EQ(file_write(filename, str.str, str.size), RET_OK);
+
+  widget_on(w, EVT_PROGRESS, on_async_load_event, events);
+  widget_on(w, EVT_DONE, on_async_load_event, events);
+  widget_on(w, EVT_ERROR, on_async_load_event, events);
+
+  base = s_new_bytes;
+  s_new_peak = s_new_bytes.load();
+  ASSERT_EQ(code_edit_load_mapped(w, filename), RET_OK);
+
+  /*文档立即显示，只索引了第一块，其余的行在空闲处理中追加。*/
+  ASSERT_EQ(code_edit_is_loading(w), TRUE);
+  ASSERT_EQ(widget_get_prop_bool(w, WIDGET_PROP_READONLY, FALSE), TRUE);
+  ASSERT_GT(code_edit_get_line_count(w), 1u);
+  ASSERT_LT(code_edit_get_line_count(w), (uint32_t)lines / 8);
+  ASSERT_LT(sci_send(w, SCI_GETLENGTH, 0, 0), (sptr_t)str.size / 8);
+
+  while (events[2] == 0 && events[3] == 0) {
+    idle_dispatch();
+    sleep_ms(1);
+  }
+  peak = s_new_peak - base;
+
+  /*文本不复制到堆上，只有行索引占用内存。*/
+  ASSERT_EQ(events[2], 1);
+  ASSERT_EQ(events[1], 100);
+  ASSERT_LT(peak, (size_t)str.size / 2);
+  ASSERT_EQ(code_edit_is_loading(w), FALSE);
+  ASSERT_EQ(code_edit_is_modified(w), FALSE);
+  ASSERT_EQ(widget_get_prop_bool(w, WIDGET_PROP_READONLY, FALSE), TRUE);
+  ASSERT_EQ(code_edit_get_line_count(w), (uint32_t)lines + 1);
+
+  /*映射的文档只读，插入不生效。*/
+  ASSERT_EQ(strlen(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL)), str.size);
+  ASSERT_NE(code_edit_replace_text(w, 0, 0, "abc"), RET_OK);
+  code_edit_insert_text(w, 0, "abc");
+  ASSERT_EQ(strncmp(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), str.str, 64), 0);
+
+  /*设置新的文本后解除映射，恢复原来的readonly设置。*/
+  ASSERT_EQ(widget_set_text_utf8(w, "int a;"), RET_OK);
+  ASSERT_STREQ(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), "int a;");
+  ASSERT_EQ(widget_get_prop_bool(w, WIDGET_PROP_READONLY, TRUE), FALSE);
+  ASSERT_EQ(code_edit_insert_text(w, 0, "/*x*/"), RET_OK);
+  ASSERT_STREQ(widget_get_prop_str(w, WIDGET_PROP_TEXT, NULL), "/*x*/int a;");
+
+  /*建立索引期间文件被截断时解除映射，不再访问文件末尾之后的页面。*/
+  memset(events, 0x00, sizeof(events));
+  ASSERT_EQ(code_edit_load_mapped(w, filename), RET_OK);
+  ASSERT_EQ(code_edit_is_loading(w), TRUE);
+  ASSERT_EQ(file_write(filename, str.str, 1024), RET_OK);
+  while (events[2] == 0 && events[3] == 0) {
+    idle_dispatch();
+    sleep_ms(1);
+  }
+  ASSERT_EQ(events[2], 0);
+  ASSERT_EQ(events[3], 1);
+  ASSERT_EQ(code_edit_is_loading(w), FALSE);
+  ASSERT_EQ(sci_send(w, SCI_GETLENGTH, 0, 0), 0);
+  ASSERT_EQ(widget_get_prop_bool(w, WIDGET_PROP_READONLY, TRUE), FALSE);
+
+  widget_destroy(w);
+  fs_remove_file(os_fs(), filename);
+  str_reset(&str);
+}
+
+TEST(code_edit, save_atomic) {
+  str_t str;
+  uint32_t size = 0;
+  char* data = NULL;
+  const char* filename = "code_edit_save_atomic_test.c";
+  std::string long_name(MAX_PATH - 2, 'a');
+  widget_t* w = code_edit_create(NULL, 10, 20, 30, 40);
+
+  ASSERT_EQ(widget_get_prop_bool(w, CODE_EDIT_PROP_ATOMIC_SAVE, TRUE), FALSE);
+  ASSERT_EQ(widget_get_prop_bool(w, CODE_EDIT_PROP_KEEP_BACKUP, TRUE), FALSE);
+
+  str_init(&str, 1024);
+  while (str.size < 8 * 1024 * 1024) {
+    str_append(&str, "static int sum(const int* a, int n) { return a[n - 1]; }\n");
+  }
+  ASSERT_EQ(widget_set_text_utf8(w, str.str), RET_OK);
+
+  ASSERT_EQ(code_edit_save(w, filename, FALSE), RET_OK);
+#ifndef WIN32
+  ASSERT_EQ(chmod(filename, 0640), 0);
+#endif /*WIN32*/
+
+  /*原子保存：写临时文件、同步、再替换原文件，原文件复制为.bak文件。
+   *临时文件名不是固定的，不会覆盖其它进程正在写的同名临时文件。*/
+  ASSERT_EQ(widget_set_prop_bool(w, CODE_EDIT_PROP_ATOMIC_SAVE, TRUE), RET_OK);
+  ASSERT_EQ(widget_set_prop_bool(w, CODE_EDIT_PROP_KEEP_BACKUP, TRUE), RET_OK);
+  ASSERT_EQ(code_edit_insert_text(w, 0, "/*new*/"), RET_OK);
+  ASSERT_EQ(file_write("code_edit_save_atomic_test.c.tmp", "other", 5), RET_OK);
+
+  ASSERT_EQ(code_edit_save(w, filename, FALSE), RET_OK);
+
+  ASSERT_EQ(fs_get_file_size(os_fs(), "code_edit_save_atomic_test.c.tmp"), 5);
+  fs_remove_file(os_fs(), "code_edit_save_atomic_test.c.tmp");
+  data = (char*)file_read(filename, &size);
+  ASSERT_EQ(size, str.size + 7);
+  ASSERT_EQ(memcmp(data, "/*new*/", 7), 0);
+  TKMEM_FREE(data);
+
+  data = (char*)file_read("code_edit_save_atomic_test.c.bak", &size);
+  ASSERT_EQ(size, str.size);
+  ASSERT_EQ(memcmp(data, str.str, str.size), 0);
+  TKMEM_FREE(data);
+
+#ifndef WIN32
+  /*替换后的文件和备份保留原文件的权限，而不是临时文件的缺省权限。*/
+  {
+    struct stat st;
+    ASSERT_EQ(stat(filename, &st), 0);
+    ASSERT_EQ(st.st_mode & 0777, 0640u);
+    ASSERT_EQ(stat("code_edit_save_atomic_test.c.bak", &st), 0);
+    ASSERT_EQ(st.st_mode & 0777, 0640u);
+  }
+#endif /*WIN32*/
+
+  /*不保留备份时直接替换原文件。*/
+  ASSERT_EQ(widget_set_prop_bool(w, CODE_EDIT_PROP_KEEP_BACKUP, FALSE), RET_OK);
+  fs_remove_file(os_fs(), "code_edit_save_atomic_test.c.bak");
+  ASSERT_EQ(code_edit_save(w, filename, FALSE), RET_OK);
+  ASSERT_EQ(fs_file_exist(os_fs(), "code_edit_save_atomic_test.c.bak"), FALSE);
+  ASSERT_EQ(fs_get_file_size(os_fs(), filename), (int32_t)(str.size + 7));
+
+  /*备份或临时文件名超过MAX_PATH时保存失败，不使用截断后的文件名。*/
+  ASSERT_NE(code_edit_save(w, long_name.c_str(), FALSE), RET_OK);
+  ASSERT_EQ(fs_file_exist(os_fs(), long_name.c_str()), FALSE);
+
+  widget_destroy(w);
+  fs_remove_file(os_fs(), filename);
+  str_reset(&str);
+}
+
+/*在后台用指定的线程数分析，结果(样式、行状态和折叠级别)应与UI线程中的同步分析完全一致。*/
+static uint32_t check_parallel_lexing(int lexer, const std::string& text, uint32_t threads) {
+  int32_t length = text.size();
+  int32_t lines = 0;
+  uint32_t chunks = 0;
+  widget_t* w = code_edit_create(NULL, 0, 0, 300, 200);
+  widget_t* sync = code_edit_create(NULL, 0, 0, 300, 200);
+
+  sci_send(sync, SCI_SETLEXER, lexer, 0);
+  sci_send(sync, SCI_SETPROPERTY, (uptr_t)"fold", (sptr_t)"1");
+  sci_send(sync, SCI_SETPROPERTY, (uptr_t)"fold.preprocessor", (sptr_t)"1");
+  sci_send(sync, SCI_SETKEYWORDS, 0, (sptr_t)"true false null");
+  widget_set_text_utf8(sync, text.c_str());
+  sci_send(sync, SCI_COLOURISE, 0, -1);
+
+  sci_send(w, SCI_SETLEXER, lexer, 0);
+  sci_send(w, SCI_SETPROPERTY, (uptr_t)"fold", (sptr_t)"1");
+  sci_send(w, SCI_SETPROPERTY, (uptr_t)"fold.preprocessor", (sptr_t)"1");
+  sci_send(w, SCI_SETKEYWORDS, 0, (sptr_t)"true false null");
+  EXPECT_EQ(code_edit_set_lex_threads(w, threads), RET_OK);
+  EXPECT_EQ(widget_get_prop_int(w, CODE_EDIT_PROP_LEX_THREADS, 0), (int32_t)threads);
+  code_edit_set_background_lexing(w, TRUE);
+  widget_set_text_utf8(w, text.c_str());
+  while (sci_send(w, SCI_GETENDSTYLED, 0, 0) < length) {
+    idle_dispatch();
+    sleep_ms(1);
+  }
+  chunks = widget_get_prop_int(w, CODE_EDIT_PROP_LEX_CHUNKS, 0);
+
+  for (int32_t i = 0; i < length; i++) {
+    if (sci_send(w, SCI_GETSTYLEAT, i, 0) != sci_send(sync, SCI_GETSTYLEAT, i, 0)) {
+      ADD_FAILURE() << "style differs at " << i;
+      break;
+    }
+  }
+  lines = sci_send(sync, SCI_GETLINECOUNT, 0, 0);
+  EXPECT_EQ(sci_send(w, SCI_GETLINECOUNT, 0, 0), lines);
+  for (int32_t i = 0; i < lines; i++) {
+    if (sci_send(w, SCI_GETLINESTATE, i, 0) != sci_send(sync, SCI_GETLINESTATE, i, 0) ||
+        sci_send(w, SCI_GETFOLDLEVEL, i, 0) != sci_send(sync, SCI_GETFOLDLEVEL, i, 0)) {
+      ADD_FAILURE() << "line state or fold level differs at line " << i;
+      break;
+    }
+  }
+
+  widget_destroy(w);
+  widget_destroy(sync);
+
+  return chunks;
+}
+
+TEST(code_edit, parallel_lexing) {
+  std::string c = "#ifndef BIG_H\n#define BIG_H\n#include <stdio.h>\n#define FEATURE 1\n\n";
+  std::string python;
+  std::string json = "[\n";
+  std::string comment = "/*\n";
+  size_t middle = 0;
+
+  for (int i = 0; c.size() < 2 * 1024 * 1024; i++) {
+    char buff[32];
+    tk_snprintf(buff, sizeof(buff), "%d", i);
+    c += std::string("/* function ") + buff + " */\nstatic int f" + buff + "(int x) {\n";
+    c += "  const char* s = \"str\\\"ing\";\n\n  if (x > 0) {\n    return x; // tail\n  }\n";
+    c += "#if FEATURE\n  x++;\n#else\n  x--;\n#endif\n  return -x;\n}\n\n";
+    if (i % 1000 == 0) {
+      c += std::string("#define VALUE_") + buff + " \\\n  " + buff + "\n\n";
+    }
+  }
+  c += "#endif /*BIG_H*/\n";
+
+  for (int i = 0; python.size() < 1536 * 1024; i++) {
+    char buff[32];
+    tk_snprintf(buff, sizeof(buff), "%d", i);
+    python += std::string("def f") + buff + "(x):\n    '''doc\n\n    string'''\n";
+    python += "    s = f'{x!r}' + \"str\"  # tail\n\n    return x\n\n\n";
+  }
+
+  while (json.size() < 1536 * 1024) {
+    json += "  {\n    \"name\": \"value\\n\",\n    \"list\": [1, 2.5, true, null]\n  },\n\n";
+  }
+  json += "  {}\n]\n";
+
+  /*按块并行分析，接缝处重新分析到结果一致，块开头的预处理状态来自之前的指令。*/
+  ASSERT_EQ(check_parallel_lexing(SCLEX_CPP, c, 4), 4u);
+  ASSERT_EQ(check_parallel_lexing(SCLEX_PYTHON, python, 4), 4u);
+  ASSERT_EQ(check_parallel_lexing(SCLEX_JSON, json, 4), 4u);
+  ASSERT_EQ(check_parallel_lexing(SCLEX_CPP, c, 1), 0u);
+
+  /*
+   * 注释中的预处理指令也进了前缀，之后各块的条件都多了一层，接缝无法对齐。保留对齐了的块，
+   * 用没有对齐的接缝之前那一块的词法分析器从接缝顺序分析到末尾。
+   */
+  comment += c;
+  ASSERT_EQ(check_parallel_lexing(SCLEX_CPP, comment, 4), 1u);
+  middle = c.find("\n\n", c.size() * 6 / 10) + 2;
+  ASSERT_EQ(check_parallel_lexing(SCLEX_CPP, c.substr(0, middle) + "/*\n#if 0\n*/\n" + c.substr(middle), 4),
+            3u);
+}